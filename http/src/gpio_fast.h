@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* GPIO fast path
+ *
+ * Writes GPIO outputs straight to the set and clear registers of their
+ * port, without opening the GPIO driver. These registers only change the
+ * pins whose bit is 1, so no read-modify-write and no lock is needed: the
+ * functions can be called from any task and from interrupt context.
+ *
+ * A struct gpio_fast is a handle on pins of one port, e.g. relays that
+ * must switch together. All the pins of a handle driven to the same level
+ * change in the same register access. gpio_fast_write() with pins going
+ * both ways takes two back to back accesses, the GPSR (set) one then the
+ * GPCR (clear) one: the pins going high change first.
+ *
+ * Pins must have been given the GPIO function and made outputs first, with
+ * the pinmux and GPIO drivers as usual.
+ *
+ * Applications are built on their own, so http, wlan/wm_demo and
+ * io_demo/gpio each carry a copy of this header. Keep them identical.
+ */
+
+#ifndef __GPIO_FAST__
+#define __GPIO_FAST__
+
+#include <wmtypes.h>
+#include <wmerrno.h>
+#include <mc200.h>
+#include <mc200_gpio.h>
+
+#define GPIO_FAST_PORT(pin)	((pin) >> 5)
+#define GPIO_FAST_BIT(pin)	(1u << ((pin) & 0x1f))
+
+/* Pins of one port, written together */
+struct gpio_fast {
+	uint8_t port;
+	uint32_t mask;
+};
+
+/** Make g a handle on n pins. Returns -WM_E_INVAL if they are not all on
+ * the same port.
+ */
+static inline int gpio_fast_group(struct gpio_fast *g, const int *pins,
+				  int n)
+{
+	int i;
+
+	if (n <= 0)
+		return -WM_E_INVAL;
+	g->port = GPIO_FAST_PORT(pins[0]);
+	g->mask = 0;
+	for (i = 0; i < n; i++) {
+		if (GPIO_FAST_PORT(pins[i]) != g->port)
+			return -WM_E_INVAL;
+		g->mask |= GPIO_FAST_BIT(pins[i]);
+	}
+	return WM_SUCCESS;
+}
+
+/** Drive the pins of port in mask high */
+static inline void gpio_fast_set(int port, uint32_t mask)
+{
+	GPIO->GPSR[port].WORDVAL = mask;
+}
+
+/** Drive the pins of port in mask low */
+static inline void gpio_fast_clear(int port, uint32_t mask)
+{
+	GPIO->GPCR[port].WORDVAL = mask;
+}
+
+/** Drive the pins of g high where val has a 1, low elsewhere. val is in
+ * port bits, like g->mask: GPIO_FAST_BIT(pin) for each pin to set.
+ */
+static inline void gpio_fast_write(const struct gpio_fast *g, uint32_t val)
+{
+	if (val & g->mask)
+		gpio_fast_set(g->port, val & g->mask);
+	if (~val & g->mask)
+		gpio_fast_clear(g->port, ~val & g->mask);
+}
+
+/** Drive one pin to GPIO_IO_LOW or GPIO_IO_HIGH */
+static inline void gpio_fast_pin(int pin, int level)
+{
+	if (level == GPIO_IO_LOW)
+		gpio_fast_clear(GPIO_FAST_PORT(pin), GPIO_FAST_BIT(pin));
+	else
+		gpio_fast_set(GPIO_FAST_PORT(pin), GPIO_FAST_BIT(pin));
+}
+
+#endif /* ! __GPIO_FAST__ */
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Admission control for WSGI handlers
+ *
+ * Keeps a flood of requests from the LAN (a misbehaving app, a scanner)
+ * from eating the CPU time and heap the rest of the application needs.
+ * Before a handler runs, the request must get past:
+ *
+ *  - a token bucket for its client address: client_rate requests per
+ *    second on average, client_burst at once. The last
+ *    HTTP_ADMIT_CLIENTS clients seen are tracked.
+ *  - a token bucket for all clients together: global_rate per second.
+ *  - a cap of max_inflight requests being handled at the same time.
+ *
+ * Requests turned away are answered right away with
+ * "503 Service Unavailable" and a Retry-After. Their headers and up to
+ * 1 KB of data are read and dropped so that a kept-alive connection stays
+ * in step, the connection is closed if there is more.
+ * A rate of 0 turns the corresponding bucket off.
+ *
+ * Handlers are wrapped when they are registered:
+ *
+ *	static int hello_get(httpd_request_t *req)
+ *	{
+ *		return http_admit_call(req, hello_handler);
+ *	}
+ */
+
+#ifndef _HTTP_ADMIT_H_
+#define _HTTP_ADMIT_H_
+
+#include <httpd.h>
+
+#define HTTP_ADMIT_CLIENTS		8
+
+#define HTTP_ADMIT_CLIENT_RATE		10
+#define HTTP_ADMIT_CLIENT_BURST		20
+#define HTTP_ADMIT_GLOBAL_RATE		40
+#define HTTP_ADMIT_MAX_INFLIGHT		2
+
+struct http_admit_cfg {
+	int client_rate;		/* requests/s, 0 for no limit */
+	int client_burst;
+	int global_rate;		/* requests/s, 0 for no limit */
+	int max_inflight;
+};
+
+struct http_admit_stats {
+	unsigned admitted;
+	unsigned rejected_client;	/* client over its rate */
+	unsigned rejected_global;	/* all clients over the global rate */
+	unsigned rejected_busy;		/* max_inflight reached */
+	unsigned evicted;		/* clients forgotten for a new one */
+	int inflight;
+	int inflight_max;		/* highest inflight seen */
+};
+
+/** Create the admission state with the default limits. Call before
+ * registering the handlers; http_admit_cli_init() calls it too.
+ */
+int http_admit_init(void);
+
+/** Admit req, or turn it away with a 503 and return -WM_E_BUSY, or
+ * -WM_FAIL if the connection must be closed as well. An admitted request
+ * must be followed by http_admit_end().
+ */
+int http_admit_begin(httpd_request_t *req);
+void http_admit_end(void);
+
+/** Run handler on req if it is admitted. Returns what the handler returns,
+ * or WM_SUCCESS if the request was turned away, -WM_FAIL if the
+ * connection must be closed.
+ */
+int http_admit_call(httpd_request_t *req,
+		    int (*handler)(httpd_request_t *req));
+
+void http_admit_get_cfg(struct http_admit_cfg *cfg);
+int http_admit_set_cfg(const struct http_admit_cfg *cfg);
+void http_admit_get_stats(struct http_admit_stats *st);
+
+/** The "httpd-admit" command: show the counters, change the limits */
+int http_admit_cli_init(void);
+
+#endif /* _HTTP_ADMIT_H_ */
@@ -0,0 +1,116 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Web-Service handlers of the application
+ *
+ * Kept apart from main.c so that they can also be built and load tested on
+ * a host, see tools/httpd_host.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <httpd.h>
+#include <http_resp.h>
+#include <http_admit.h>
+#include <http_handlers.h>
+
+/*
+ * A simple HTTP Web-Service Handler
+ *
+ * Returns the string "Hello World" when a GET on http://<IP>/hello
+ * is done.
+ */
+char *hello_world_string = "<html><head></head><body><center><h1>Hello Tapu!!!</h1></body></html>\n";
+
+int hello_handler(httpd_request_t *req)
+{
+	return httpd_send_response(req, HTTP_RES_200, hello_world_string,
+				   strlen(hello_world_string), "text/html");
+}
+
+/* The handlers as registered, behind admission control */
+static int hello_get(httpd_request_t *req)
+{
+	return http_admit_call(req, hello_handler);
+}
+
+struct httpd_wsgi_call hello_wsgi_handler = {
+	"/hello",
+	HTTPD_DEFAULT_HDR_FLAGS,
+	0,
+	hello_get,
+	NULL,
+	NULL,
+	NULL
+};
+
+int led_get_handler(httpd_request_t *req)
+{
+	struct http_resp r;
+	int ret;
+
+	ret = http_resp_begin(&r, req, "text/plain");
+	if (ret != WM_SUCCESS)
+		return ret;
+
+	http_resp_printf(&r, "LED State: %d", gpio_led_get_state());
+	return http_resp_send(&r, HTTP_RES_200);
+}
+
+int led_post_handler(httpd_request_t *req)
+{
+	char state;
+
+	if (httpd_get_data(req, &state, 1) < 0)
+		return -WM_FAIL;
+
+	if (state == '1') {
+		gpio_led_on();
+		return httpd_send_response(req, HTTP_RES_200,
+					   "Successfully switched on",
+					   sizeof("Successfully switched on") - 1,
+					   "text/html");
+	}
+
+	gpio_led_off();
+	return httpd_send_response(req, HTTP_RES_200,
+				   "Successfully switched off",
+				   sizeof("Successfully switched off") - 1,
+				   "text/html");
+}
+
+static int led_get(httpd_request_t *req)
+{
+	return http_admit_call(req, led_get_handler);
+}
+
+static int led_post(httpd_request_t *req)
+{
+	return http_admit_call(req, led_post_handler);
+}
+
+struct httpd_wsgi_call led_wsgi_handler = {
+	"/led",
+	HTTPD_DEFAULT_HDR_FLAGS,
+	0,
+	led_get,
+	led_post,
+	NULL,
+	NULL
+};
+
+/*
+ * Register Web-Service handlers
+ *
+ */
+int register_httpd_handlers()
+{
+	if (http_resp_init() != WM_SUCCESS ||
+	    http_admit_init() != WM_SUCCESS)
+		return -WM_FAIL;
+	httpd_register_wsgi_handler(&hello_wsgi_handler);
+	httpd_register_wsgi_handler(&led_wsgi_handler);
+	return WM_SUCCESS;
+}
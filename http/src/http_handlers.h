@@ -0,0 +1,23 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _HTTP_HANDLERS_H_
+#define _HTTP_HANDLERS_H_
+
+#include <httpd.h>
+
+int hello_handler(httpd_request_t *req);
+int led_get_handler(httpd_request_t *req);
+int led_post_handler(httpd_request_t *req);
+
+/** Register the /hello and /led handlers */
+int register_httpd_handlers();
+
+/* LED control, provided by main.c */
+void gpio_led_on(void);
+void gpio_led_off(void);
+unsigned int gpio_led_get_state(void);
+
+#endif /* _HTTP_HANDLERS_H_ */
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Per-request scratch arena and response builder for WSGI handlers
+ *
+ * A handler takes one of HTTP_RESP_ARENAS fixed buffers for the duration
+ * of the request, builds its response body in it and sends it:
+ *
+ *	struct http_resp r;
+ *
+ *	if (http_resp_begin(&r, req, HTTP_CONTENT_PLAIN_TEXT_STR) !=
+ *	    WM_SUCCESS)
+ *		return -WM_E_AGAIN;
+ *	http_resp_printf(&r, "LED State: %d", state);
+ *	return http_resp_send(&r, HTTP_RES_200);
+ *
+ * The body grows from the start of the buffer and scratch allocations
+ * (http_resp_alloc(), request data) from its end. Nothing is freed
+ * individually: the whole buffer is handed back in one go when the
+ * response is sent or aborted.
+ *
+ * A body that fits is sent with a Content-Length. Once the buffer is full,
+ * the response switches to chunked transfer encoding and the buffer
+ * content is sent as a chunk, so the body size is not limited by the
+ * buffer size. The status of a chunked response is always 200.
+ *
+ * The state lives in the handler's struct http_resp and the buffers are
+ * never shared, so handlers do not need any global buffer.
+ *
+ * If building the body failed, the response is a 500, or a truncated
+ * body once the response went chunked.
+ *
+ * Applications are built on their own, so http/src and wlan/wm_demo/src
+ * each carry a copy of http_resp.c and http_resp.h. Keep them identical.
+ */
+
+#ifndef _HTTP_RESP_H_
+#define _HTTP_RESP_H_
+
+#include <httpd.h>
+#include <json.h>
+
+#define HTTP_RESP_ARENAS	2
+#define HTTP_RESP_ARENA_LEN	1024
+
+struct http_resp {
+	httpd_request_t *req;
+	char *buf;
+	int len;		/* body, from the start of buf */
+	int top;		/* scratch, from top to the end of buf */
+	int json_start;		/* body length when the json_str was opened */
+	bool chunked;		/* headers sent, body goes out in chunks */
+	const char *type;
+	int err;		/* first error, reported by http_resp_send() */
+	struct json_str jstr;
+};
+
+/** Create the arena pool. Call once before registering the handlers. */
+int http_resp_init(void);
+
+/** Take an arena for a response of the given content type to req.
+ * Returns -WM_E_AGAIN if all are in use.
+ */
+int http_resp_begin(struct http_resp *r, httpd_request_t *req,
+		    const char *type);
+
+/** Scratch memory, valid until the response is sent or aborted */
+void *http_resp_alloc(struct http_resp *r, int size);
+
+int http_resp_append(struct http_resp *r, const char *data, int len);
+int http_resp_printf(struct http_resp *r, const char *fmt, ...);
+
+/** Start JSON output in the rest of the arena. The returned json_str is
+ * used with the json_* API, then http_resp_json_end() appends what was
+ * written to the body. A JSON document cannot be larger than the space
+ * left in the arena when it is started.
+ */
+struct json_str *http_resp_json_begin(struct http_resp *r);
+int http_resp_json_end(struct http_resp *r);
+
+/** Read the request data (up to maxlen bytes) into the arena and parse it
+ * as JSON into obj.
+ */
+int http_resp_get_json(struct http_resp *r, struct json_object *obj,
+		       int maxlen);
+
+/** Send the response with the given status (e.g. HTTP_RES_200) and hand
+ * the arena back.
+ */
+int http_resp_send(struct http_resp *r, const char *status);
+
+/** Hand the arena back without sending anything */
+void http_resp_abort(struct http_resp *r);
+
+#endif /* _HTTP_RESP_H_ */
@@ -59,12 +59,15 @@
 #include <wmsysinfo.h>
 #include <wm_net.h>
 #include <httpd.h>
+#include <http_handlers.h>
+#include <http_admit.h>
 
 #include <wm_os.h>
 #include <mdev_gpio.h>
 #include <mdev_pinmux.h>
 #include <mc200/mc200_gpio.h>
 #include <board.h>
+#include <gpio_fast.h>
 
 
 /*------------------Macro Definitions ------------------*/
@@ -85,8 +88,6 @@ static unsigned int gpio_led_state;
 /*-----------------------Global functions declarations----------------------*/
 int appln_config_init();
 void appln_critical_error_handler(void *data);
-int hello_handler(httpd_request_t *req);
-int register_httpd_handlers();
 void event_uap_started(void *data);
 void event_uap_stopped(void *data);
 void event_wlan_init_done(void *data);
@@ -94,8 +95,6 @@ int common_event_handler(int event, void *data);
 static void modules_init();
 
 static void configure_gpios();
-static void gpio_led_on(void);
-static void gpio_led_off(void);
 static void configure_gpios();
 
 /*-----------------------Application Main entry point ----------------------*/
@@ -167,6 +166,13 @@ static void modules_init()
 		appln_critical_error_handler((void *) -WM_FAIL);
 	}
 
+	/*
+	 * Register the HTTP admission control CLI Command
+	 */
+	ret = http_admit_cli_init();
+	if (ret != WM_SUCCESS)
+		dbg("Error: http_admit_cli_init failed");
+
 	return;
 }
 
@@ -263,81 +269,6 @@ void event_wlan_init_done(void *data)
 }
 
 
-/*
- * A simple HTTP Web-Service Handler
- *
- * Returns the string "Hello World" when a GET on http://<IP>/hello
- * is done.
- */
-char *hello_world_string = "<html><head></head><body><center><h1>Hello Tapu!!!</h1></body></html>\n";
-
-int hello_handler(httpd_request_t *req)
-{
-	char *content = hello_world_string;
-	httpd_send_response(req, HTTP_RES_200, content, strlen(content),"text/html");
-	return WM_SUCCESS;
-}
-
-struct httpd_wsgi_call hello_wsgi_handler = {
-	"/hello",
-	HTTPD_DEFAULT_HDR_FLAGS,
-	0,
-	hello_handler,
-	NULL,
-	NULL,
-	NULL
-};
-
-int led_get_handler(httpd_request_t *req)
-{
-	char *content = "Success";
-	snprintf(content, 100, "LED State: %d", gpio_led_state);
-	
-	httpd_send_response(req, HTTP_RES_200, content, strlen(content),"text/plain");
-	return WM_SUCCESS;
-}
-
-int led_post_handler(httpd_request_t *req)
-{
-	char state;
-	char *responseOn = "Successfully switched on";
-	char *responseOff = "Successfully switched off";
-
-	httpd_get_data(req, &state, 1);
-
-	if(state=='1') {
-		gpio_led_on();
-		httpd_send_response(req, HTTP_RES_200, responseOn, strlen(responseOn),"text/html");
-	}
-	else {
-		gpio_led_off();
-		httpd_send_response(req, HTTP_RES_200, responseOff, strlen(responseOff),"text/html");
-	}
-
-	return WM_SUCCESS;
-}
-
-struct httpd_wsgi_call led_wsgi_handler = {
-	"/led",
-	HTTPD_DEFAULT_HDR_FLAGS,
-	0,
-	led_get_handler,
-	led_post_handler,
-	NULL,
-	NULL
-};
-
-/*
- * Register Web-Service handlers
- *
- */
-int register_httpd_handlers()
-{
-	httpd_register_wsgi_handler(&hello_wsgi_handler);
-	httpd_register_wsgi_handler(&led_wsgi_handler);
-	return WM_SUCCESS;
-}
-
 /*
  * Handler invoked when the Micro-AP Network interface
  * is ready.
@@ -393,24 +324,25 @@ static void configure_gpios()
 }
 
 /* This function turns on the LED*/
-static void gpio_led_on(void)
+void gpio_led_on(void)
 {
-	mdev_t *gpio_dev = gpio_drv_open("MDEV_GPIO");
 	/* Turn on LED by writing  0 in GPIO register */
-	gpio_drv_write(gpio_dev, gpio_led, 0);
-	gpio_drv_close(gpio_dev);
+	gpio_fast_pin(gpio_led, GPIO_IO_LOW);
 	gpio_led_state = 1;
 }
 
 /* This function turns off the LED*/
-static void gpio_led_off(void)
+void gpio_led_off(void)
 {
-	mdev_t *gpio_dev = gpio_drv_open("MDEV_GPIO");
 	/* Turn off LED by writing  1 in GPIO register */
-	gpio_drv_write(gpio_dev, gpio_led, 1);
-	gpio_drv_close(gpio_dev);
+	gpio_fast_pin(gpio_led, GPIO_IO_HIGH);
 	gpio_led_state = 0;
 }
 
+unsigned int gpio_led_get_state(void)
+{
+	return gpio_led_state;
+}
+
 
 
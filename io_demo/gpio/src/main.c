@@ -9,6 +9,7 @@
 #include <mdev_pinmux.h>
 #include <mc200/mc200_gpio.h>
 #include <board.h>
+#include <gpio_fast.h>
 
 /*
  * Simple Application which uses GPIO driver.
@@ -45,20 +46,16 @@ static unsigned int gpio_led_state;
 /* This function turns on the LED*/
 static void gpio_led_on(void)
 {
-	mdev_t *gpio_dev = gpio_drv_open("MDEV_GPIO");
 	/* Turn on LED by writing  0 in GPIO register */
-	gpio_drv_write(gpio_dev, gpio_led, 0);
-	gpio_drv_close(gpio_dev);
+	gpio_fast_pin(gpio_led, GPIO_IO_LOW);
 	gpio_led_state = 1;
 }
 
 /* This function turns off the LED*/
 static void gpio_led_off(void)
 {
-	mdev_t *gpio_dev = gpio_drv_open("MDEV_GPIO");
 	/* Turn off LED by writing  1 in GPIO register */
-	gpio_drv_write(gpio_dev, gpio_led, 1);
-	gpio_drv_close(gpio_dev);
+	gpio_fast_pin(gpio_led, GPIO_IO_HIGH);
 	gpio_led_state = 0;
 }
 
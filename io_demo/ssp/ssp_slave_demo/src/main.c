@@ -28,10 +28,14 @@
 #include <wmstdio.h>
 #include <wm_os.h>
 #include <mdev_ssp.h>
+#include <wake_audit.h>
 
 /* Buffer length */
 #define BUF_LEN 16
 
+/* Print the wakeup audit every this many reads */
+#define AUDIT_EVERY 100
+
 /* Thread handle */
 static os_thread_t app_thread;
 
@@ -50,11 +54,17 @@ static void ssp_slave_read(os_thread_arg_t data)
 	wmprintf("ssp_slave_demo Application Started\r\n");
 
 	int len, i, cnt = 0;
+	static struct wake_point wp = {"ssp_slave"};
 
 	while (1) {
 		cnt++;
 		/* Read data from SSP bus */
 		len = ssp_drv_read(ssp0, read_data, BUF_LEN);
+		/* Polls the bus: the master sent something or not */
+		if (cnt > 1)
+			wake_audit(&wp, WAKE_TIMEOUT, len > 0);
+		if (cnt % AUDIT_EVERY == 0)
+			wake_audit_dump();
 		wmprintf("Read iteration %d:\r\n", cnt);
 
 		for (i = 0; i < len ; i++)
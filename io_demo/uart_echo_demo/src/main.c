@@ -20,10 +20,14 @@
 #include <wmstdio.h>
 #include <mdev_uart.h>
 #include <wmstdio.h>
+#include <wake_audit.h>
 
 /* Size of UART buffer */
 #define BUFSIZE 256
 
+/* Print the wakeup audit about once a minute */
+#define AUDIT_EVERY 600
+
 /* Buffer for read and write*/
 char buf[BUFSIZE];
 
@@ -34,6 +38,9 @@ int main(void)
 	int count = 0, len;
 	char temp;
 	mdev_t *dev;
+	static struct wake_point wp = {"uart_echo"};
+	unsigned wakeups = 0;
+	bool slept = false;
 
 	/* Initialize wmstdio console on UART0 */
 	wmstdio_init(UART1_ID, 0);
@@ -57,6 +64,13 @@ int main(void)
 	while (1) {
 		/* Read one character from UART1 Port. */
 		len = uart_drv_read(dev, (uint8_t *)&temp, 1);
+		/* Polls the UART: a character came in during the sleep or not */
+		if (slept) {
+			slept = false;
+			wake_audit(&wp, WAKE_TIMEOUT, len > 0);
+			if (++wakeups % AUDIT_EVERY == 0)
+				wake_audit_dump();
+		}
 		if (len > 0 && (temp == 13 || count == (BUFSIZE - 3))) {
 			temp = '\n';
 			uart_drv_write(dev, (uint8_t *)&temp, 1);
@@ -77,6 +91,7 @@ int main(void)
 		}
 
 		os_thread_sleep(os_msec_to_ticks(100));
+		slept = true;
 	}
 
 	return 0;
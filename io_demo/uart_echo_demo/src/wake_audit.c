@@ -0,0 +1,108 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <json.h>
+#include <cli.h>
+#include <wake_audit.h>
+
+static const char *wake_reason_names[WAKE_REASONS] = {
+	"timeout", "sem", "isr", "msg",
+};
+
+static struct wake_point *wake_points;
+
+void wake_audit(struct wake_point *p, enum wake_reason why, bool work)
+{
+	unsigned long flags;
+
+	if (!p->first) {
+		p->first = os_ticks_get() | 1;
+		flags = os_enter_critical_section();
+		p->next = wake_points;
+		wake_points = p;
+		os_exit_critical_section(flags);
+	}
+	if (why < WAKE_REASONS)
+		p->count[why]++;
+	if (!work)
+		p->idle++;
+}
+
+static unsigned wake_total(const struct wake_point *p)
+{
+	unsigned n = 0;
+	int i;
+
+	for (i = 0; i < WAKE_REASONS; i++)
+		n += p->count[i];
+	return n;
+}
+
+/* Wakeups per minute since the first one */
+static unsigned wake_rate(const struct wake_point *p, unsigned n)
+{
+	unsigned long ms = os_ticks_to_msec(os_ticks_get() - p->first);
+
+	return ms ? (unsigned long long)n * 60000 / ms : 0;
+}
+
+void wake_audit_dump(void)
+{
+	struct wake_point *p;
+	unsigned n;
+	int i;
+
+	wmprintf("%-12s", "thread");
+	for (i = 0; i < WAKE_REASONS; i++)
+		wmprintf(" %8s", wake_reason_names[i]);
+	wmprintf(" %8s %5s %7s\r\n", "idle", "idle%", "per min");
+	for (p = wake_points; p; p = p->next) {
+		n = wake_total(p);
+		wmprintf("%-12s", p->name);
+		for (i = 0; i < WAKE_REASONS; i++)
+			wmprintf(" %8u", p->count[i]);
+		wmprintf(" %8u %4u%% %7u\r\n", p->idle,
+			 n ? p->idle * 100 / n : 0, wake_rate(p, n));
+	}
+}
+
+void wake_audit_json(struct json_str *jstr)
+{
+	struct wake_point *p;
+	int i;
+
+	for (p = wake_points; p; p = p->next) {
+		json_push_object(jstr, p->name);
+		for (i = 0; i < WAKE_REASONS; i++)
+			json_set_val_int(jstr, wake_reason_names[i],
+					 p->count[i]);
+		json_set_val_int(jstr, "idle", p->idle);
+		json_set_val_int(jstr, "per_min",
+				 wake_rate(p, wake_total(p)));
+		json_pop_object(jstr);
+	}
+}
+
+static void wake_audit_cmd(int argc, char **argv)
+{
+	wake_audit_dump();
+}
+
+static struct cli_command wake_audit_cmds[] = {
+	{"wake-audit", NULL, wake_audit_cmd},
+};
+
+int wake_audit_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(wake_audit_cmds) / sizeof(struct cli_command);
+	     i++)
+		if (cli_register_command(&wake_audit_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
@@ -0,0 +1,60 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Wakeup audit
+ *
+ * Counts, for each instrumented thread, why it woke up and whether there
+ * was anything to do when it did. A thread that wakes on a timeout to
+ * find nothing keeps the CPU out of PM2 for nothing; that shows here as a
+ * high count of idle wakeups, where a change of the code can remove it.
+ *
+ * Each thread has its own wake point and is the only one to update it:
+ *
+ *	static struct wake_point wp = {"cloud"};
+ *
+ *	ret = os_semaphore_get(&sem, os_msec_to_ticks(100));
+ *	...work...
+ *	wake_audit(&wp, ret == WM_SUCCESS ? WAKE_SEM : WAKE_TIMEOUT, did_work);
+ *
+ * Applications are built on their own, so wlan/wm_demo and the io_demo
+ * UART and SSP demos each carry a copy of wake_audit.c and wake_audit.h.
+ * Keep them identical.
+ */
+
+#ifndef _WAKE_AUDIT_H_
+#define _WAKE_AUDIT_H_
+
+#include <wmtypes.h>
+#include <json.h>
+
+enum wake_reason {
+	WAKE_TIMEOUT = 0,	/* sleep or wait timed out */
+	WAKE_SEM,		/* semaphore or mutex from another thread */
+	WAKE_ISR,		/* semaphore or queue fed by an interrupt */
+	WAKE_MSG,		/* data on a socket, queue or driver */
+	WAKE_REASONS,
+};
+
+struct wake_point {
+	const char *name;
+	unsigned count[WAKE_REASONS];
+	unsigned idle;			/* wakeups with nothing to do */
+	unsigned long first;		/* ticks, first wakeup */
+	struct wake_point *next;
+};
+
+/** Record a wakeup of the thread owning p. Registers p on first use. */
+void wake_audit(struct wake_point *p, enum wake_reason why, bool work);
+
+/** Print the table of all the wake points */
+void wake_audit_dump(void);
+
+/** Add the wake points to jstr, one object each */
+void wake_audit_json(struct json_str *jstr);
+
+/** Register the "wake-audit" CLI command */
+int wake_audit_cli_init(void);
+
+#endif /* _WAKE_AUDIT_H_ */
@@ -0,0 +1,43 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* http application side of the harness: the real handlers, with the LED
+ * kept in a variable.
+ */
+#include <wm_os.h>
+#include <httpd.h>
+#include <http_handlers.h>
+#include "bench.h"
+
+const char bench_app_name[] = "http";
+
+const struct bench_target bench_targets[] = {
+	{"GET", "/hello", NULL, NULL},
+	{"GET", "/led", NULL, NULL},
+	{"POST", "/led", "1", HTTP_CONTENT_PLAIN_TEXT_STR},
+};
+const int bench_targets_no = sizeof(bench_targets) / sizeof(bench_targets[0]);
+
+static unsigned int led_state;
+
+void gpio_led_on(void)
+{
+	led_state = 1;
+}
+
+void gpio_led_off(void)
+{
+	led_state = 0;
+}
+
+unsigned int gpio_led_get_state(void)
+{
+	return led_state;
+}
+
+int bench_app_init(void)
+{
+	return register_httpd_handlers();
+}
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* wm_demo side of the harness: the real handlers, property table and
+ * serial number code, with the board and the cloud stubbed out.
+ */
+#include <string.h>
+#include <wm_os.h>
+#include <wlan.h>
+#include <wm_net.h>
+#include <wmcloud.h>
+#include <wm_demo_props.h>
+#include <wm_demo_http.h>
+#include <wm_demo_lan.h>
+#include "bench.h"
+
+const char bench_app_name[] = "wm_demo";
+
+const struct bench_target bench_targets[] = {
+	{"GET", "/hello", NULL, NULL},
+	{"POST", "/hello", "{\"onOff\":1}", HTTP_CONTENT_JSON_STR},
+	{"POST", "/hello", "{\"secKey\":\"0123456789abcdef\"}",
+	 HTTP_CONTENT_JSON_STR},
+	{"GET", "/cloud_ui", NULL, NULL},
+};
+const int bench_targets_no = sizeof(bench_targets) / sizeof(bench_targets[0]);
+
+static int led_state;
+
+int wm_demo_switch_get(struct prop_val *val)
+{
+	val->i = led_state;
+	return WM_SUCCESS;
+}
+
+int wm_demo_switch_set(const struct prop_val *val)
+{
+	led_state = val->i;
+	return WM_SUCCESS;
+}
+
+int wlan_get_mac_address(uint8_t *dest)
+{
+	static const uint8_t mac[6] = {0x00, 0x50, 0x43, 0x02, 0xfe, 0x01};
+
+	memcpy(dest, mac, sizeof(mac));
+	return WM_SUCCESS;
+}
+
+void *net_get_uap_handle(void)
+{
+	return NULL;
+}
+
+void hp_mdns_deannounce(void *iface)
+{
+}
+
+int wm_demo_lan_set_key(const char *key)
+{
+	return WM_SUCCESS;
+}
+
+/* As with the cloud not started */
+int cloud_get_ui_link(httpd_request_t *req)
+{
+	return httpd_send_response(req, HTTP_RES_200, CLOUD_INACTIVE,
+				   strlen(CLOUD_INACTIVE),
+				   HTTP_CONTENT_PLAIN_TEXT_STR);
+}
+
+int bench_app_init(void)
+{
+	if (wm_demo_props_init() != WM_SUCCESS)
+		return -WM_FAIL;
+	return register_httpd_handlers();
+}
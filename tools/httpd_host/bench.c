@@ -0,0 +1,313 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Load generator for the application web handlers
+ *
+ * Starts the handlers behind httpd_posix.c on the loopback interface and,
+ * for each target of the application and each concurrency level, sends a
+ * number of requests from that many client threads. Reported per level:
+ * throughput, median and 99th percentile latency, os_mem allocations per
+ * request and the peak of os_mem memory in use, and how many responses
+ * were not a 200 (503 when a handler ran out of response arenas or the
+ * request was turned away by admission control).
+ *
+ * Admission control is off unless -a is given: then all requests come
+ * from one client, over the device's per-client rate, and the counters
+ * show how much load was shed.
+ *
+ *	httpd_host_wm_demo [-c 1,2,4,8] [-n requests] [-t server threads]
+ *			   [-a] [-v]
+ *	httpd_host_wm_demo -s [-p port] [-t server threads]
+ *
+ * -s only serves, for poking at the handlers with curl or a browser.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <wm_os.h>
+#include <httpd.h>
+#include <http_admit.h>
+#include "bench.h"
+
+#define BENCH_MAX_LEVELS	8
+#define BENCH_RESP_LEN		4096
+
+struct bench_run {
+	const struct bench_target *t;
+	char req[512];
+	int req_len;
+	int requests;
+	int next;			/* next request to send */
+	unsigned long *lat_us;
+	int non_200;
+	int failed;
+};
+
+static int server_port;
+
+static unsigned long now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+/* One request on a fresh connection. Returns the HTTP status, -1 if the
+ * exchange failed. The response is kept in resp if given.
+ */
+static int bench_request(const char *req, int req_len, char *resp,
+			 int resp_len)
+{
+	static const struct linger lng = {1, 0};
+	struct sockaddr_in addr;
+	char buf[BENCH_RESP_LEN];
+	int sock, n, len = 0, one = 1, status = -1;
+
+	if (!resp) {
+		resp = buf;
+		resp_len = sizeof(buf);
+	}
+
+	sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0)
+		return -1;
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	/* Reset on close: no TIME_WAIT pile-up over thousands of requests */
+	setsockopt(sock, SOL_SOCKET, SO_LINGER, &lng, sizeof(lng));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(server_port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    send(sock, req, req_len, MSG_NOSIGNAL) != req_len)
+		goto out;
+
+	/* The server closes after the response */
+	while ((n = recv(sock, resp + len, resp_len - 1 - len, 0)) > 0) {
+		len += n;
+		if (len == resp_len - 1)
+			len = 0;	/* only the start matters */
+	}
+	resp[len] = 0;
+	if (n == 0 && sscanf(resp, "HTTP/1.%*d %d", &status) != 1)
+		status = -1;
+out:
+	close(sock);
+	return status;
+}
+
+static void *bench_client(void *arg)
+{
+	struct bench_run *run = arg;
+	unsigned long start;
+	int i, status;
+
+	while ((i = __sync_fetch_and_add(&run->next, 1)) < run->requests) {
+		start = now_us();
+		status = bench_request(run->req, run->req_len, NULL, 0);
+		run->lat_us[i] = now_us() - start;
+		if (status < 0)
+			__sync_fetch_and_add(&run->failed, 1);
+		else if (status != 200)
+			__sync_fetch_and_add(&run->non_200, 1);
+	}
+	return NULL;
+}
+
+static int cmp_ul(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *)a;
+	unsigned long y = *(const unsigned long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void bench_level(struct bench_run *run, int clients)
+{
+	pthread_t tid[64];
+	struct host_mem_stats before, after;
+	unsigned long start, elapsed;
+	int i;
+
+	run->next = 0;
+	run->non_200 = 0;
+	run->failed = 0;
+	host_mem_reset_peak();
+	host_mem_stats(&before);
+
+	start = now_us();
+	for (i = 0; i < clients; i++)
+		pthread_create(&tid[i], NULL, bench_client, run);
+	for (i = 0; i < clients; i++)
+		pthread_join(tid[i], NULL);
+	elapsed = now_us() - start;
+
+	host_mem_stats(&after);
+	qsort(run->lat_us, run->requests, sizeof(run->lat_us[0]), cmp_ul);
+
+	printf("%-22s %4d %9.0f %8.2f %8.2f %9.2f %7.0f %7lu %7d\n",
+	       "", clients, run->requests * 1e6 / elapsed,
+	       run->lat_us[run->requests / 2] / 1000.0,
+	       run->lat_us[run->requests * 99 / 100] / 1000.0,
+	       (double)(after.allocs - before.allocs) / run->requests,
+	       (double)(after.bytes - before.bytes) / run->requests,
+	       after.peak - before.in_use,
+	       run->non_200 + run->failed);
+}
+
+static void bench_prepare(struct bench_run *run, const struct bench_target *t)
+{
+	int body_len = t->body ? strlen(t->body) : 0;
+
+	run->t = t;
+	run->req_len = snprintf(run->req, sizeof(run->req),
+				"%s %s HTTP/1.1\r\nHost: localhost\r\n",
+				t->method, t->uri);
+	if (t->body)
+		run->req_len += snprintf(run->req + run->req_len,
+					 sizeof(run->req) - run->req_len,
+					 "Content-Type: %s\r\n"
+					 "Content-Length: %d\r\n\r\n%s",
+					 t->type, body_len, t->body);
+	else
+		run->req_len += snprintf(run->req + run->req_len,
+					 sizeof(run->req) - run->req_len,
+					 "\r\n");
+}
+
+static int parse_levels(char *arg, int *levels)
+{
+	char *tok;
+	int n = 0;
+
+	for (tok = strtok(arg, ","); tok && n < BENCH_MAX_LEVELS;
+	     tok = strtok(NULL, ",")) {
+		levels[n] = atoi(tok);
+		if (levels[n] < 1 || levels[n] > 64)
+			return -1;
+		n++;
+	}
+	return n;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-c 1,2,4,8] [-n requests] "
+		"[-t server threads] [-a] [-v]\n"
+		"       %s -s [-p port] [-t server threads]\n", prog, prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	int levels[BENCH_MAX_LEVELS] = {1, 2, 4, 8};
+	int levels_no = 4, requests = 2000, threads = 1, port = 0;
+	bool serve = false, verbose = false, admit = false;
+	struct http_admit_cfg cfg;
+	struct http_admit_stats st;
+	struct bench_run run;
+	char resp[BENCH_RESP_LEN];
+	int opt, i, j;
+
+	while ((opt = getopt(argc, argv, "c:n:t:p:sva")) != -1) {
+		switch (opt) {
+		case 'c':
+			levels_no = parse_levels(optarg, levels);
+			if (levels_no <= 0)
+				usage(argv[0]);
+			break;
+		case 'n':
+			requests = atoi(optarg);
+			if (requests < 1)
+				usage(argv[0]);
+			break;
+		case 't':
+			threads = atoi(optarg);
+			break;
+		case 'p':
+			port = atoi(optarg);
+			break;
+		case 's':
+			serve = true;
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		case 'a':
+			admit = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (bench_app_init() != WM_SUCCESS) {
+		fprintf(stderr, "%s: handler registration failed\n",
+			bench_app_name);
+		return 1;
+	}
+	if (!admit) {
+		memset(&cfg, 0, sizeof(cfg));
+		http_admit_set_cfg(&cfg);
+	}
+	if (serve && !port)
+		port = 8080;
+	server_port = httpd_host_start(port, threads);
+	if (server_port < 0) {
+		fprintf(stderr, "cannot start the server\n");
+		return 1;
+	}
+
+	if (serve) {
+		printf("%s handlers on http://127.0.0.1:%d/\n", bench_app_name,
+		       server_port);
+		while (1)
+			pause();
+	}
+
+	run.requests = requests;
+	run.lat_us = malloc(requests * sizeof(run.lat_us[0]));
+	if (!run.lat_us)
+		return 1;
+
+	printf("%s: %d server thread(s), %d requests per level\n\n",
+	       bench_app_name, threads, requests);
+	printf("%-22s %4s %9s %8s %8s %9s %7s %7s %7s\n", "target", "conc",
+	       "req/s", "p50 ms", "p99 ms", "allocs/r", "B/r", "peak B",
+	       "non-200");
+
+	for (i = 0; i < bench_targets_no; i++) {
+		char name[64];
+
+		bench_prepare(&run, &bench_targets[i]);
+		snprintf(name, sizeof(name), "%s %s", run.t->method,
+			 run.t->uri);
+		printf("%s\n", name);
+		if (verbose) {
+			bench_request(run.req, run.req_len, resp,
+				      sizeof(resp));
+			printf("%s\n\n", resp);
+		}
+		for (j = 0; j < levels_no; j++)
+			bench_level(&run, levels[j]);
+	}
+
+	http_admit_get_stats(&st);
+	printf("\nadmitted %u, rejected: client %u global %u busy %u, "
+	       "inflight max %d\n", st.admitted, st.rejected_client,
+	       st.rejected_global, st.rejected_busy, st.inflight_max);
+
+	free(run.lat_us);
+	return 0;
+}
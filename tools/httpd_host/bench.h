@@ -0,0 +1,25 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/* A request the load generator sends over and over */
+struct bench_target {
+	const char *method;
+	const char *uri;
+	const char *body;		/* NULL for none */
+	const char *type;		/* of the body */
+};
+
+/* Provided by the application side of each harness binary */
+extern const char bench_app_name[];
+extern const struct bench_target bench_targets[];
+extern const int bench_targets_no;
+
+/** Register the application's handlers, as its main.c does on the device */
+int bench_app_init(void);
+
+#endif /* _BENCH_H_ */
@@ -0,0 +1,158 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* JSON generator and top-level value lookup for the host harness */
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <json.h>
+
+void json_str_init(struct json_str *jptr, char *buff, int len, int is_cont)
+{
+	jptr->buff = buff;
+	jptr->len = len;
+	jptr->free_ptr = 0;
+	if (len)
+		buff[0] = 0;
+}
+
+/* Like the SDK, stop one byte short of the end when the buffer is full */
+static int json_put(struct json_str *jptr, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static int json_put(struct json_str *jptr, const char *fmt, ...)
+{
+	int room = jptr->len - jptr->free_ptr - 1;
+	va_list ap;
+	int n;
+
+	if (room <= 0)
+		return -WM_E_JSON_FAIL;
+	va_start(ap, fmt);
+	n = vsnprintf(jptr->buff + jptr->free_ptr, room, fmt, ap);
+	va_end(ap);
+	if (n >= room) {
+		jptr->free_ptr += room - 1;
+		return -WM_E_JSON_FAIL;
+	}
+	jptr->free_ptr += n;
+	return WM_SUCCESS;
+}
+
+/* A separator is needed unless the value opens its container */
+static const char *json_sep(struct json_str *jptr)
+{
+	char last = jptr->free_ptr ? jptr->buff[jptr->free_ptr - 1] : '{';
+
+	return last == '{' || last == '[' ? "" : ",";
+}
+
+int json_start_object(struct json_str *jptr)
+{
+	return json_put(jptr, "%s{", jptr->free_ptr ? json_sep(jptr) : "");
+}
+
+int json_close_object(struct json_str *jptr)
+{
+	return json_put(jptr, "}");
+}
+
+int json_set_val_str(struct json_str *jptr, const char *name,
+		     const char *val)
+{
+	return json_put(jptr, "%s\"%s\":\"%s\"", json_sep(jptr), name, val);
+}
+
+int json_set_val_int(struct json_str *jptr, const char *name, int val)
+{
+	return json_put(jptr, "%s\"%s\":%d", json_sep(jptr), name, val);
+}
+
+int json_object_init(struct json_object *obj, char *buff)
+{
+	while (isspace((unsigned char)*buff))
+		buff++;
+	if (*buff != '{')
+		return -WM_E_JSON_FAIL;
+	obj->str = buff;
+	obj->array_obj = 0;
+	obj->current_obj = 0;
+	return WM_SUCCESS;
+}
+
+/* Start of the value of a top-level "name" */
+static const char *json_find(struct json_object *obj, const char *name)
+{
+	int len = strlen(name), depth = 0;
+	const char *p = obj->str;
+	bool in_str = false;
+
+	for (; *p; p++) {
+		if (in_str) {
+			if (*p == '\\' && p[1])
+				p++;
+			else if (*p == '"')
+				in_str = false;
+			continue;
+		}
+		if (*p == '{' || *p == '[') {
+			depth++;
+		} else if (*p == '}' || *p == ']') {
+			depth--;
+		} else if (*p == '"') {
+			if (depth == 1 && !strncmp(p + 1, name, len) &&
+			    p[len + 1] == '"') {
+				const char *v = p + len + 2;
+
+				while (isspace((unsigned char)*v))
+					v++;
+				if (*v == ':') {
+					v++;
+					while (isspace((unsigned char)*v))
+						v++;
+					return v;
+				}
+			}
+			in_str = true;
+		}
+	}
+	return NULL;
+}
+
+int json_get_val_str(struct json_object *obj, const char *name, char *val,
+		     int maxlen)
+{
+	const char *p = json_find(obj, name);
+	int n = 0;
+
+	if (!p || *p != '"')
+		return -WM_E_JSON_NOT_FOUND;
+	for (p++; *p && *p != '"'; p++) {
+		if (*p == '\\' && p[1])
+			p++;
+		if (n == maxlen - 1)
+			return -WM_E_JSON_FAIL;
+		val[n++] = *p;
+	}
+	val[n] = 0;
+	return *p == '"' ? WM_SUCCESS : -WM_E_JSON_FAIL;
+}
+
+int json_get_val_int(struct json_object *obj, const char *name, int *val)
+{
+	const char *p = json_find(obj, name);
+	char *end;
+	long v;
+
+	if (!p)
+		return -WM_E_JSON_NOT_FOUND;
+	v = strtol(p, &end, 10);
+	if (end == p)
+		return -WM_E_JSON_NOT_FOUND;
+	*val = v;
+	return WM_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* OS abstraction layer and CLI for the host harness */
+#include <stdlib.h>
+#include <time.h>
+#include <wm_os.h>
+#include <cli.h>
+
+/* Each os_mem block starts with its size, for the in-use accounting */
+#define MEM_HDR_LEN	16
+
+/* Nothing runs out of memory on the host: report what the device would
+ * have left with its usual free heap.
+ */
+#define HOST_HEAP_LEN	(96 * 1024)
+
+static pthread_mutex_t mem_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct host_mem_stats mem;
+
+int os_mutex_create(os_mutex_t *mhandle, const char *name, int flags)
+{
+	pthread_mutexattr_t attr;
+
+	*mhandle = malloc(sizeof(pthread_mutex_t));
+	if (!*mhandle)
+		return -WM_E_NOMEM;
+
+	pthread_mutexattr_init(&attr);
+	if (flags == OS_MUTEX_INHERIT)
+		pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+	pthread_mutex_init(*mhandle, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return WM_SUCCESS;
+}
+
+int os_mutex_get(os_mutex_t *mhandle, unsigned long wait)
+{
+	if (wait == OS_NO_WAIT)
+		return pthread_mutex_trylock(*mhandle) ? -WM_FAIL : WM_SUCCESS;
+	return pthread_mutex_lock(*mhandle) ? -WM_FAIL : WM_SUCCESS;
+}
+
+int os_mutex_put(os_mutex_t *mhandle)
+{
+	return pthread_mutex_unlock(*mhandle) ? -WM_FAIL : WM_SUCCESS;
+}
+
+int os_mutex_delete(os_mutex_t *mhandle)
+{
+	pthread_mutex_destroy(*mhandle);
+	free(*mhandle);
+	*mhandle = NULL;
+	return WM_SUCCESS;
+}
+
+unsigned long os_ticks_get(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+static void mem_account(long delta, bool alloc)
+{
+	pthread_mutex_lock(&mem_mutex);
+	if (alloc) {
+		mem.allocs++;
+		if (delta > 0)
+			mem.bytes += delta;
+	}
+	mem.in_use += delta;
+	if (mem.in_use > mem.peak)
+		mem.peak = mem.in_use;
+	pthread_mutex_unlock(&mem_mutex);
+}
+
+void *os_mem_alloc(size_t size)
+{
+	char *p = malloc(size + MEM_HDR_LEN);
+
+	if (!p)
+		return NULL;
+	*(size_t *)p = size;
+	mem_account(size, true);
+	return p + MEM_HDR_LEN;
+}
+
+void *os_mem_calloc(size_t size)
+{
+	char *p = calloc(1, size + MEM_HDR_LEN);
+
+	if (!p)
+		return NULL;
+	*(size_t *)p = size;
+	mem_account(size, true);
+	return p + MEM_HDR_LEN;
+}
+
+void os_mem_free(void *ptr)
+{
+	char *p = ptr;
+
+	if (!p)
+		return;
+	p -= MEM_HDR_LEN;
+	mem_account(-(long)*(size_t *)p, false);
+	free(p);
+}
+
+void *os_mem_realloc(void *ptr, size_t size)
+{
+	size_t old;
+	char *p;
+
+	if (!ptr)
+		return os_mem_alloc(size);
+	p = (char *)ptr - MEM_HDR_LEN;
+	old = *(size_t *)p;
+	p = realloc(p, size + MEM_HDR_LEN);
+	if (!p)
+		return NULL;
+	*(size_t *)p = size;
+	mem_account((long)size - (long)old, true);
+	return p + MEM_HDR_LEN;
+}
+
+size_t os_get_free_size(void)
+{
+	size_t in_use;
+
+	pthread_mutex_lock(&mem_mutex);
+	in_use = mem.in_use;
+	pthread_mutex_unlock(&mem_mutex);
+	return in_use < HOST_HEAP_LEN ? HOST_HEAP_LEN - in_use : 0;
+}
+
+void host_mem_stats(struct host_mem_stats *st)
+{
+	pthread_mutex_lock(&mem_mutex);
+	*st = mem;
+	pthread_mutex_unlock(&mem_mutex);
+}
+
+void host_mem_reset_peak(void)
+{
+	pthread_mutex_lock(&mem_mutex);
+	mem.peak = mem.in_use;
+	pthread_mutex_unlock(&mem_mutex);
+}
+
+int cli_register_command(const struct cli_command *command)
+{
+	return WM_SUCCESS;
+}
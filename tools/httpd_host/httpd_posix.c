@@ -0,0 +1,376 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Minimal POSIX stand-in for the WMSDK HTTP server
+ *
+ * Enough of the server to run the applications' WSGI handlers unchanged:
+ * one request per connection (the device closes after each response too),
+ * dispatch on the URI with the query string stripped, request data read
+ * through httpd_get_data()/httpd_get_data_json().
+ *
+ * The device serves requests from a single thread. With more than one
+ * server thread, handlers run concurrently, which is how contention on
+ * their shared state (e.g. the response arenas) shows up.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <wm_os.h>
+#include <httpd.h>
+
+#define HTTPD_MAX_HANDLERS	16
+#define HTTPD_MAX_THREADS	16
+#define HTTPD_HDR_LEN		1024
+
+/* Request being served by the current thread */
+struct httpd_conn {
+	httpd_request_t req;
+	char hdr[HTTPD_HDR_LEN];
+	int hdr_len;
+	char *data;		/* request data received with the headers */
+	int data_len;
+	bool sent;		/* something was sent back */
+};
+
+static __thread struct httpd_conn *cur;
+static struct httpd_wsgi_call *handlers[HTTPD_MAX_HANDLERS];
+static int handlers_no;
+static int listen_sock = -1;
+
+int httpd_register_wsgi_handler(struct httpd_wsgi_call *wsgi_call)
+{
+	if (handlers_no == HTTPD_MAX_HANDLERS)
+		return -WM_E_NOSPC;
+	handlers[handlers_no++] = wsgi_call;
+	return WM_SUCCESS;
+}
+
+int httpd_register_wsgi_handlers(struct httpd_wsgi_call *wsgi_call_list,
+				 int handlers_no)
+{
+	int i;
+
+	for (i = 0; i < handlers_no; i++)
+		if (httpd_register_wsgi_handler(&wsgi_call_list[i]) !=
+		    WM_SUCCESS)
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+int httpd_send(int sock, const char *buf, int len)
+{
+	int n;
+
+	if (cur)
+		cur->sent = true;
+	while (len > 0) {
+		n = send(sock, buf, len, MSG_NOSIGNAL);
+		if (n <= 0)
+			return -WM_FAIL;
+		buf += n;
+		len -= n;
+	}
+	return WM_SUCCESS;
+}
+
+int httpd_send_header(int sock, const char *name, const char *value)
+{
+	char line[256];
+	int n;
+
+	n = snprintf(line, sizeof(line), "%s: %s\r\n", name, value);
+	if (n >= sizeof(line))
+		return -WM_E_INVAL;
+	return httpd_send(sock, line, n);
+}
+
+int httpd_send_default_headers(int sock, int hdr_fields)
+{
+	static const struct {
+		int flag;
+		const char *line;
+	} hdrs[] = {
+		{HTTPD_HDR_ADD_SERVER, "Server: Marvell-WM\r\n"},
+		{HTTPD_HDR_ADD_CONN_CLOSE, "Connection: close\r\n"},
+		{HTTPD_HDR_ADD_CONN_KEEP_ALIVE, "Connection: keep-alive\r\n"},
+		{HTTPD_HDR_ADD_TYPE_CHUNKED, "Transfer-Encoding: chunked\r\n"},
+		{HTTPD_HDR_ADD_CACHE_CTRL,
+		 "Cache-Control: max-age=3600, must-revalidate\r\n"},
+		{HTTPD_HDR_ADD_CACHE_CTRL_NO_CHK,
+		 "Cache-Control: post-check=0, pre-check=0\r\n"},
+		{HTTPD_HDR_ADD_PRAGMA_NO_CACHE, "Pragma: no-cache\r\n"},
+	};
+	int i;
+
+	for (i = 0; i < sizeof(hdrs) / sizeof(hdrs[0]); i++)
+		if ((hdr_fields & hdrs[i].flag) &&
+		    httpd_send(sock, hdrs[i].line, strlen(hdrs[i].line)) !=
+		    WM_SUCCESS)
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+int httpd_send_crlf(int sock)
+{
+	return httpd_send(sock, "\r\n", 2);
+}
+
+int httpd_send_chunk(int sock, const char *buf, int len)
+{
+	char line[16];
+	int n;
+
+	n = snprintf(line, sizeof(line), "%x\r\n", len);
+	if (httpd_send(sock, line, n) != WM_SUCCESS)
+		return -WM_FAIL;
+	if (len && httpd_send(sock, buf, len) != WM_SUCCESS)
+		return -WM_FAIL;
+	return httpd_send_crlf(sock);
+}
+
+int httpd_send_response(httpd_request_t *req, const char *first_line,
+			const char *content, int length,
+			const char *content_type)
+{
+	int hdr_fields = req->wsgi ? req->wsgi->hdr_fields :
+		HTTPD_DEFAULT_HDR_FLAGS;
+	char line[64];
+	int n;
+
+	n = snprintf(line, sizeof(line), "HTTP/1.1 %s\r\n", first_line);
+	if (httpd_send(req->sock, line, n) != WM_SUCCESS ||
+	    httpd_send_default_headers(req->sock, hdr_fields) != WM_SUCCESS ||
+	    httpd_send_header(req->sock, "Content-Type", content_type) !=
+	    WM_SUCCESS)
+		return -WM_FAIL;
+	n = snprintf(line, sizeof(line), "%d", length);
+	if (httpd_send_header(req->sock, "Content-Length", line) !=
+	    WM_SUCCESS ||
+	    httpd_send_crlf(req->sock) != WM_SUCCESS)
+		return -WM_FAIL;
+	if (length && httpd_send(req->sock, content, length) != WM_SUCCESS)
+		return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+int httpd_recv(int sock, void *buf, size_t n, int flags)
+{
+	return recv(sock, buf, n, flags);
+}
+
+/* The headers are all read before the handler runs */
+int httpd_purge_headers(int sock)
+{
+	return WM_SUCCESS;
+}
+
+int httpd_get_data(httpd_request_t *req, char *content, int length)
+{
+	int got = 0, n;
+
+	if (length > req->remaining_bytes)
+		length = req->remaining_bytes;
+
+	/* What came with the headers first */
+	if (cur && cur->data_len) {
+		n = cur->data_len < length ? cur->data_len : length;
+		memcpy(content, cur->data, n);
+		cur->data += n;
+		cur->data_len -= n;
+		got = n;
+	}
+	while (got < length) {
+		n = recv(req->sock, content + got, length - got, 0);
+		if (n <= 0)
+			return -WM_FAIL;
+		got += n;
+	}
+	req->remaining_bytes -= got;
+	return got;
+}
+
+int httpd_get_data_json(httpd_request_t *req, char *content, int length,
+			struct json_object *obj)
+{
+	int n;
+
+	if (length < 2)
+		return -WM_E_INVAL;
+	n = httpd_get_data(req, content, length - 1);
+	if (n < 0)
+		return n;
+	content[n] = 0;
+	if (json_object_init(obj, content) != WM_SUCCESS)
+		return -WM_FAIL;
+	return n;
+}
+
+/* Read the request line and headers. Returns -WM_FAIL on a bad request. */
+static int httpd_read_hdr(struct httpd_conn *c)
+{
+	char *eoh = NULL, *p, *uri, *q;
+	int n;
+
+	while (!eoh) {
+		if (c->hdr_len == sizeof(c->hdr) - 1)
+			return -WM_FAIL;
+		n = recv(c->req.sock, c->hdr + c->hdr_len,
+			 sizeof(c->hdr) - 1 - c->hdr_len, 0);
+		if (n <= 0)
+			return -WM_FAIL;
+		c->hdr_len += n;
+		c->hdr[c->hdr_len] = 0;
+		eoh = strstr(c->hdr, "\r\n\r\n");
+	}
+	c->data = eoh + 4;
+	c->data_len = c->hdr + c->hdr_len - c->data;
+
+	if (!strncmp(c->hdr, "GET ", 4))
+		c->req.type = HTTP_GET;
+	else if (!strncmp(c->hdr, "POST ", 5))
+		c->req.type = HTTP_POST;
+	else if (!strncmp(c->hdr, "PUT ", 4))
+		c->req.type = HTTP_PUT;
+	else if (!strncmp(c->hdr, "DELETE ", 7))
+		c->req.type = HTTP_DELETE;
+	else
+		return -WM_FAIL;
+
+	uri = strchr(c->hdr, ' ') + 1;
+	q = strchr(uri, ' ');
+	if (!q || q - uri > HTTPD_MAX_URI_LENGTH)
+		return -WM_FAIL;
+	memcpy(c->req.filename, uri, q - uri);
+	c->req.filename[q - uri] = 0;
+
+	for (p = strstr(c->hdr, "\r\n"); p && p < eoh;
+	     p = strstr(p + 2, "\r\n"))
+		if (!strncasecmp(p + 2, "Content-Length:", 15))
+			c->req.body_nbytes = atoi(p + 17);
+	c->req.remaining_bytes = c->req.body_nbytes;
+	c->req.hdr_parsed = true;
+	return WM_SUCCESS;
+}
+
+static struct httpd_wsgi_call *httpd_find(const char *uri)
+{
+	int len = strcspn(uri, "?"), i;
+
+	for (i = 0; i < handlers_no; i++) {
+		const char *h = handlers[i]->uri;
+		int hlen = strlen(h);
+
+		if (handlers[i]->http_flags & APP_HTTP_FLAGS_NO_EXACT_MATCH ?
+		    !strncmp(uri, h, hlen) :
+		    hlen == len && !strncmp(uri, h, len))
+			return handlers[i];
+	}
+	return NULL;
+}
+
+static void httpd_error(httpd_request_t *req, const char *status)
+{
+	httpd_send_response(req, status, status, strlen(status),
+			    HTTP_CONTENT_PLAIN_TEXT_STR);
+}
+
+static void httpd_serve(int sock)
+{
+	struct httpd_conn c;
+	struct httpd_wsgi_call *h;
+	int (*fn)(httpd_request_t *) = NULL;
+	int ret;
+
+	memset(&c, 0, sizeof(c));
+	c.req.sock = sock;
+	cur = &c;
+
+	if (httpd_read_hdr(&c) != WM_SUCCESS) {
+		httpd_error(&c.req, HTTP_RES_400);
+		goto out;
+	}
+
+	h = httpd_find(c.req.filename);
+	if (h) {
+		c.req.wsgi = h;
+		switch (c.req.type) {
+		case HTTP_GET: fn = h->get_handler; break;
+		case HTTP_POST: fn = h->set_handler; break;
+		case HTTP_PUT: fn = h->put_handler; break;
+		case HTTP_DELETE: fn = h->delete_handler; break;
+		}
+	}
+	if (!fn) {
+		httpd_error(&c.req, HTTP_RES_404);
+		goto out;
+	}
+
+	/* A handler failing before it answered gets an error status: 503 if
+	 * it only ran out of some resource for now
+	 */
+	ret = fn(&c.req);
+	if (ret != WM_SUCCESS && !c.sent)
+		httpd_error(&c.req, ret == -WM_E_AGAIN ? HTTP_RES_503 :
+			    HTTP_RES_500);
+out:
+	cur = NULL;
+	close(sock);
+}
+
+static void *httpd_main(void *arg)
+{
+	int sock, one = 1;
+
+	while (1) {
+		sock = accept(listen_sock, NULL, NULL);
+		if (sock < 0)
+			continue;
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		httpd_serve(sock);
+	}
+	return NULL;
+}
+
+int httpd_host_start(int port, int threads)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	pthread_t tid;
+	int one = 1, i;
+
+	if (threads < 1 || threads > HTTPD_MAX_THREADS)
+		return -WM_E_INVAL;
+
+	listen_sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listen_sock < 0)
+		return -WM_FAIL;
+	setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listen_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listen_sock, 128) < 0 ||
+	    getsockname(listen_sock, (struct sockaddr *)&addr, &len) < 0) {
+		close(listen_sock);
+		listen_sock = -1;
+		return -WM_FAIL;
+	}
+
+	for (i = 0; i < threads; i++) {
+		if (pthread_create(&tid, NULL, httpd_main, NULL))
+			return -WM_FAIL;
+		pthread_detach(tid);
+	}
+	return ntohs(addr.sin_port);
+}
@@ -0,0 +1,19 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Host stand-in for the CLI: commands are registered but never run */
+
+#ifndef _CLI_H_
+#define _CLI_H_
+
+struct cli_command {
+	const char *name;
+	const char *help;
+	void (*function)(int argc, char **argv);
+};
+
+int cli_register_command(const struct cli_command *command);
+
+#endif /* _CLI_H_ */
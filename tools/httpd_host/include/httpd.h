@@ -0,0 +1,93 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Host stand-in for the WMSDK HTTP server API, see httpd_posix.c */
+
+#ifndef _HTTPD_H_
+#define _HTTPD_H_
+
+#include <wmtypes.h>
+#include <wmerrno.h>
+#include <json.h>
+
+#define HTTPD_MAX_URI_LENGTH	128
+
+#define HTTP_GET	1
+#define HTTP_POST	2
+#define HTTP_PUT	3
+#define HTTP_DELETE	4
+
+#define HTTP_RES_200	"200 OK"
+#define HTTP_RES_304	"304 Not Modified"
+#define HTTP_RES_400	"400 Bad Request"
+#define HTTP_RES_404	"404 Not Found"
+#define HTTP_RES_500	"500 Internal Server Error"
+#define HTTP_RES_503	"503 Service Unavailable"
+
+#define HTTP_CONTENT_PLAIN_TEXT_STR	"text/plain"
+#define HTTP_CONTENT_JSON_STR		"application/json"
+#define HTTP_CONTENT_HTML_STR		"text/html"
+
+#define HTTPD_JSON_SUCCESS	"{\"success\": 0}"
+#define HTTPD_JSON_ERROR	"{\"error\": -1}"
+
+/* Headers added by httpd_send_default_headers() */
+#define HTTPD_HDR_ADD_SERVER		0x0001
+#define HTTPD_HDR_ADD_CONN_CLOSE	0x0002
+#define HTTPD_HDR_ADD_CONN_KEEP_ALIVE	0x0004
+#define HTTPD_HDR_ADD_TYPE_CHUNKED	0x0008
+#define HTTPD_HDR_ADD_CACHE_CTRL	0x0010
+#define HTTPD_HDR_ADD_CACHE_CTRL_NO_CHK	0x0020
+#define HTTPD_HDR_ADD_PRAGMA_NO_CACHE	0x0040
+#define HTTPD_DEFAULT_HDR_FLAGS		(HTTPD_HDR_ADD_SERVER | \
+					 HTTPD_HDR_ADD_CONN_CLOSE)
+
+#define APP_HTTP_FLAGS_NO_EXACT_MATCH	0x0001
+
+typedef struct {
+	int type;			/* HTTP_GET, HTTP_POST, ... */
+	char filename[HTTPD_MAX_URI_LENGTH + 1];	/* URI, query included */
+	int sock;
+	int remaining_bytes;		/* request data not read yet */
+	int body_nbytes;		/* Content-Length */
+	bool hdr_parsed;
+	const struct httpd_wsgi_call *wsgi;
+} httpd_request_t;
+
+struct httpd_wsgi_call {
+	const char *uri;
+	int hdr_fields;
+	int http_flags;
+	int (*get_handler)(httpd_request_t *req);
+	int (*set_handler)(httpd_request_t *req);
+	int (*put_handler)(httpd_request_t *req);
+	int (*delete_handler)(httpd_request_t *req);
+};
+
+int httpd_register_wsgi_handler(struct httpd_wsgi_call *wsgi_call);
+int httpd_register_wsgi_handlers(struct httpd_wsgi_call *wsgi_call_list,
+				 int handlers_no);
+
+int httpd_send(int sock, const char *buf, int len);
+int httpd_send_header(int sock, const char *name, const char *value);
+int httpd_send_default_headers(int sock, int hdr_fields);
+int httpd_send_crlf(int sock);
+int httpd_send_chunk(int sock, const char *buf, int len);
+int httpd_send_response(httpd_request_t *req, const char *first_line,
+			const char *content, int length,
+			const char *content_type);
+
+int httpd_recv(int sock, void *buf, size_t n, int flags);
+int httpd_purge_headers(int sock);
+int httpd_get_data(httpd_request_t *req, char *content, int length);
+int httpd_get_data_json(httpd_request_t *req, char *content, int length,
+			struct json_object *obj);
+
+/** Host only: serve on 127.0.0.1:port (0 picks a free port) with the
+ * given number of server threads. Returns the port or -WM_FAIL.
+ */
+int httpd_host_start(int port, int threads);
+
+#endif /* _HTTPD_H_ */
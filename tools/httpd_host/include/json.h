@@ -0,0 +1,46 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Host stand-in for the WMSDK JSON generator and parser
+ *
+ * The generator writes the same output as the SDK one. The parser only
+ * looks up top-level string and integer values, which is all the web
+ * handlers do.
+ */
+
+#ifndef _JSON_H_
+#define _JSON_H_
+
+#include <wmtypes.h>
+#include <wmerrno.h>
+
+#define WM_E_JSON_FAIL		100
+#define WM_E_JSON_NOT_FOUND	101
+
+struct json_str {
+	char *buff;
+	int len;
+	int free_ptr;
+};
+
+struct json_object {
+	char *str;
+	int array_obj;
+	int current_obj;
+};
+
+void json_str_init(struct json_str *jptr, char *buff, int len, int is_cont);
+int json_start_object(struct json_str *jptr);
+int json_close_object(struct json_str *jptr);
+int json_set_val_str(struct json_str *jptr, const char *name,
+		     const char *val);
+int json_set_val_int(struct json_str *jptr, const char *name, int val);
+
+int json_object_init(struct json_object *obj, char *buff);
+int json_get_val_str(struct json_object *obj, const char *name, char *val,
+		     int maxlen);
+int json_get_val_int(struct json_object *obj, const char *name, int *val);
+
+#endif /* _JSON_H_ */
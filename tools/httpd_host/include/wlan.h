@@ -0,0 +1,13 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _WLAN_H_
+#define _WLAN_H_
+
+#include <wmtypes.h>
+
+int wlan_get_mac_address(uint8_t *dest);
+
+#endif /* _WLAN_H_ */
@@ -0,0 +1,16 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _WM_NET_H_
+#define _WM_NET_H_
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+void *net_get_uap_handle(void);
+void *net_get_sta_handle(void);
+
+#endif /* _WM_NET_H_ */
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Host stand-in for the OS abstraction layer, on top of pthreads
+ *
+ * Ticks are milliseconds. os_mem_*() keep count of what the code under
+ * test allocates, see host_mem_stats().
+ */
+
+#ifndef _WM_OS_H_
+#define _WM_OS_H_
+
+#include <pthread.h>
+#include <wmtypes.h>
+#include <wmerrno.h>
+
+#define OS_WAIT_FOREVER		0xffffffff
+#define OS_NO_WAIT		0
+#define OS_MUTEX_INHERIT	1
+#define OS_MUTEX_NO_INHERIT	0
+
+typedef pthread_mutex_t *os_mutex_t;
+
+int os_mutex_create(os_mutex_t *mhandle, const char *name, int flags);
+int os_mutex_get(os_mutex_t *mhandle, unsigned long wait);
+int os_mutex_put(os_mutex_t *mhandle);
+int os_mutex_delete(os_mutex_t *mhandle);
+
+unsigned long os_ticks_get(void);
+#define os_msec_to_ticks(msecs)	(msecs)
+#define os_ticks_to_msec(ticks)	(ticks)
+
+void *os_mem_alloc(size_t size);
+void *os_mem_calloc(size_t size);
+void *os_mem_realloc(void *ptr, size_t size);
+void os_mem_free(void *ptr);
+size_t os_get_free_size(void);
+
+struct host_mem_stats {
+	unsigned long allocs;		/* os_mem_*alloc() calls */
+	unsigned long bytes;		/* bytes requested by them */
+	unsigned long in_use;		/* bytes not freed yet */
+	unsigned long peak;		/* highest in_use */
+};
+
+/** Snapshot of the os_mem_*() counters */
+void host_mem_stats(struct host_mem_stats *st);
+/** Restart peak from the current use */
+void host_mem_reset_peak(void);
+
+#endif /* _WM_OS_H_ */
@@ -0,0 +1,20 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Host stand-in for the application's wmcloud.h: the cloud itself is not
+ * built, only the names the web handlers share with it.
+ */
+
+#ifndef _WMCLOUD_H_
+#define _WMCLOUD_H_
+
+#include <httpd.h>
+
+#define CLOUD_INACTIVE	"Cloud inactive"
+#define QUERY_STR	"?"
+
+int cloud_get_ui_link(httpd_request_t *req);
+
+#endif /* _WMCLOUD_H_ */
@@ -0,0 +1,22 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _WMERRNO_H_
+#define _WMERRNO_H_
+
+enum wm_errno {
+	WM_SUCCESS = 0,
+	WM_FAIL = 1,
+	WM_E_PERM = 2,
+	WM_E_NOENT = 3,
+	WM_E_IO = 5,
+	WM_E_AGAIN = 11,
+	WM_E_NOMEM = 12,
+	WM_E_BUSY = 16,
+	WM_E_INVAL = 22,
+	WM_E_NOSPC = 28,
+};
+
+#endif /* _WMERRNO_H_ */
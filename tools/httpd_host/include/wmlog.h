@@ -0,0 +1,16 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _WMLOG_H_
+#define _WMLOG_H_
+
+#include <wmstdio.h>
+
+#define wmlog(_mod_, _fmt_, ...)				\
+	wmprintf("[%s] "_fmt_"\n\r", _mod_, ##__VA_ARGS__)
+#define wmlog_e(_mod_, _fmt_, ...)				\
+	wmprintf("[%s] Error: "_fmt_"\n\r", _mod_, ##__VA_ARGS__)
+
+#endif /* _WMLOG_H_ */
@@ -0,0 +1,15 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _WMSTDIO_H_
+#define _WMSTDIO_H_
+
+#include <stdio.h>
+#include <wmtypes.h>
+#include <wmerrno.h>
+
+#define wmprintf	printf
+
+#endif /* _WMSTDIO_H_ */
@@ -0,0 +1,19 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Host stand-in for the WMSDK headers: only what the web handlers use */
+
+#ifndef _WMTYPES_H_
+#define _WMTYPES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define WARN_UNUSED_RET	__attribute__((warn_unused_result))
+#define PACK_START
+#define PACK_END	__attribute__((packed))
+
+#endif /* _WMTYPES_H_ */
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <mdev_gpt.h>
+#include <mc200_gpio.h>
+#include <mc200_pinmux.h>
+#include <led_indicator.h>
+#include <led_pwm.h>
+
+struct led_pwm_map {
+	int pin;
+	GPT_ID_Type gpt;
+	GPT_ChannelNumber_Type channel;
+	int func;			/* pin function of the channel output */
+};
+
+/* Board table: LEDs wired to a pin with a GPT channel output function.
+ * It is empty: the LEDs of the boards this application ships with
+ * (GPIO_28, GPIO_30, GPIO_78) are on pins without one, so none of them is
+ * dimmed by hardware and they all take the software path. Add an entry
+ * for a board that has such an LED, e.g.
+ *
+ *	{GPIO_0, GPT0_ID, GPT_CH_0, PINMUX_FUNCTION_1},
+ */
+static const struct led_pwm_map pwm_map[] = {
+	{-1},
+};
+
+struct led_pwm {
+	const struct led_pwm_map *map;
+	mdev_t *dev;
+	bool running;
+};
+
+static struct led_pwm pwm[sizeof(pwm_map) / sizeof(pwm_map[0])];
+
+static struct led_pwm *pwm_find(int pin)
+{
+	int i;
+
+	for (i = 0; pwm_map[i].pin >= 0; i++)
+		if (pwm_map[i].pin == pin)
+			return &pwm[i];
+	return NULL;
+}
+
+int led_pwm_init(int pin)
+{
+	struct led_pwm *p = pwm_find(pin);
+	int i;
+
+	if (!p)
+		return -WM_FAIL;
+	if (p->dev)
+		return WM_SUCCESS;
+
+	i = p - pwm;
+	if (gpt_drv_init(pwm_map[i].gpt) != WM_SUCCESS)
+		return -WM_FAIL;
+	p->dev = gpt_drv_open(pwm_map[i].gpt);
+	if (!p->dev)
+		return -WM_FAIL;
+	p->map = &pwm_map[i];
+	return WM_SUCCESS;
+}
+
+int led_pwm_set(int pin, int level)
+{
+	struct led_pwm *p = pwm_find(pin);
+	uint32_t on;
+
+	if (!p || !p->dev || level <= 0 || level >= LED_LEVEL_MAX)
+		return -WM_E_INVAL;
+
+	/* The LEDs are lit with the pin low: "on" is the low time */
+	on = LED_PWM_PERIOD * level / LED_LEVEL_MAX;
+	if (gpt_drv_pwm(p->dev, p->map->channel, LED_PWM_PERIOD - on, on) !=
+	    WM_SUCCESS)
+		return -WM_FAIL;
+	if (!p->running) {
+		GPIO_PinMuxFun(pin, p->map->func);
+		gpt_drv_start(p->dev);
+		p->running = true;
+	}
+	return WM_SUCCESS;
+}
+
+void led_pwm_stop(int pin)
+{
+	struct led_pwm *p = pwm_find(pin);
+
+	if (!p || !p->running)
+		return;
+	gpt_drv_stop(p->dev);
+	GPIO_PinMuxFun(pin, PINMUX_FUNCTION_0);
+	p->running = false;
+}
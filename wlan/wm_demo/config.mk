@@ -4,6 +4,18 @@ APPCONFIG_PM_ENABLE=y
 APPCONFIG_OVERLAY_ENABLE=n
 APPCONFIG_HTTPS_CLOUD=n
 
+# Number of work queue threads running deferred event handler work (1-3)
+APPCONFIG_WQ_WORKERS=2
+# Stack of each of them, in bytes (see wq-stats for the free stack)
+APPCONFIG_WQ_STACK_SIZE=2048
+
+# Seconds between background Wi-Fi scans while provisioning
+APPCONFIG_SCAN_INTERVAL=15
+
+# Start the event stream, scan cache and local control after the first
+# connection instead of at WLAN init
+APPCONFIG_DEFER_LOCAL=n
+
 # Select the type of cloud to be enabled with wm_demo
 # Set WEBSOCKET_CLOUD to y for websocket based cloud
 # Set LONG_POLL_CLOUD to y for long polling based cloud
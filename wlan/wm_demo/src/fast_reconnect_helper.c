@@ -0,0 +1,183 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <stdlib.h>
+#include <app_framework.h>
+#include <wlan.h>
+#include <psm.h>
+#include <appln_dbg.h>
+#include <wm_demo_wq.h>
+#include <wm_demo_boot.h>
+#include <fast_reconnect_helper.h>
+
+#define FC_MOD_NAME		"network"
+#define VAR_FC_SSID		"fc_ssid"
+#define VAR_FC_CHANNEL		"fc_channel"
+#define VAR_FC_BSSID		"fc_bssid"
+#define VAR_FC_SECURITY		"fc_security"
+
+#define FC_BSSID_STR_LEN	17	/* xx:xx:xx:xx:xx:xx */
+
+enum fc_state {
+	FC_IDLE,
+	FC_DIRECTED,		/* directed connect to the cached AP */
+	FC_FULL_SCAN,
+};
+
+static enum fc_state fc_state;
+static unsigned long fc_start;	/* ticks */
+
+static int fc_get_int(const char *var, int *val)
+{
+	char buf[12];
+
+	if (psm_get_single(FC_MOD_NAME, var, buf, sizeof(buf)) != WM_SUCCESS
+	    || !buf[0])
+		return -WM_FAIL;
+	*val = atoi(buf);
+	return WM_SUCCESS;
+}
+
+static int fc_parse_bssid(const char *str, char *bssid)
+{
+	char *end;
+	int i;
+
+	if (strlen(str) != FC_BSSID_STR_LEN)
+		return -WM_FAIL;
+	for (i = 0; i < 6; i++) {
+		bssid[i] = strtoul(str + 3 * i, &end, 16);
+		if (end != str + 3 * i + 2)
+			return -WM_FAIL;
+	}
+	return WM_SUCCESS;
+}
+
+static void fc_format_bssid(const char *bssid, char *str)
+{
+	const uint8_t *b = (const uint8_t *)bssid;
+
+	snprintf(str, FC_BSSID_STR_LEN + 1, "%02x:%02x:%02x:%02x:%02x:%02x",
+		 b[0], b[1], b[2], b[3], b[4], b[5]);
+}
+
+/* Build a directed network from the configured one and the cache */
+static int fc_load(struct wlan_network *net)
+{
+	char ssid[IEEEtypes_SSID_SIZE + 1];
+	char bssid[FC_BSSID_STR_LEN + 1];
+	int channel, security;
+
+	if (app_load_configured_network(net) != WM_SUCCESS)
+		return -WM_FAIL;
+
+	/* The cache is only valid for the network it was recorded on */
+	if (psm_get_single(FC_MOD_NAME, VAR_FC_SSID, ssid, sizeof(ssid))
+	    != WM_SUCCESS || strcmp(ssid, net->ssid))
+		return -WM_FAIL;
+	if (fc_get_int(VAR_FC_CHANNEL, &channel) != WM_SUCCESS ||
+	    channel <= 0 || channel > 165)
+		return -WM_FAIL;
+	if (fc_get_int(VAR_FC_SECURITY, &security) != WM_SUCCESS ||
+	    security != net->security.type)
+		return -WM_FAIL;
+	if (psm_get_single(FC_MOD_NAME, VAR_FC_BSSID, bssid, sizeof(bssid))
+	    != WM_SUCCESS || fc_parse_bssid(bssid, net->bssid) != WM_SUCCESS)
+		return -WM_FAIL;
+
+	net->channel = channel;
+	net->channel_specific = 1;
+	net->bssid_specific = 1;
+	return WM_SUCCESS;
+}
+
+int hp_fast_reconnect_sta_start(void)
+{
+	struct wlan_network net;
+
+	fc_start = os_ticks_get();
+
+	memset(&net, 0, sizeof(net));
+	if (fc_load(&net) == WM_SUCCESS) {
+		dbg("Fast reconnect: channel %u", net.channel);
+		if (app_sta_start_by_network(&net) == WM_SUCCESS) {
+			fc_state = FC_DIRECTED;
+			return WM_SUCCESS;
+		}
+	}
+
+	fc_state = FC_FULL_SCAN;
+	return app_sta_start();
+}
+
+static void fc_set_if_changed(const char *var, const char *val)
+{
+	char old[IEEEtypes_SSID_SIZE + 1];
+
+	/* Avoid flash writes on every reconnection to the same AP */
+	if (psm_get_single(FC_MOD_NAME, var, old, sizeof(old)) == WM_SUCCESS
+	    && !strcmp(old, val))
+		return;
+	if (psm_set_single(FC_MOD_NAME, var, val) != WM_SUCCESS)
+		dbg("Error: fast reconnect: psm set %s failed", var);
+}
+
+static void fc_save(void *arg)
+{
+	struct wlan_network net;
+	char buf[FC_BSSID_STR_LEN + 1];
+
+	if (wlan_get_current_network(&net) != WM_SUCCESS)
+		return;
+
+	fc_set_if_changed(VAR_FC_SSID, net.ssid);
+	snprintf(buf, sizeof(buf), "%u", net.channel);
+	fc_set_if_changed(VAR_FC_CHANNEL, buf);
+	fc_format_bssid(net.bssid, buf);
+	fc_set_if_changed(VAR_FC_BSSID, buf);
+	snprintf(buf, sizeof(buf), "%d", net.security.type);
+	fc_set_if_changed(VAR_FC_SECURITY, buf);
+}
+
+void hp_fast_reconnect_connected(void)
+{
+	if (fc_state != FC_IDLE) {
+		dbg("Time to connected: %u ms (%s), %d ms since reset",
+		    os_ticks_to_msec(os_ticks_get() - fc_start),
+		    fc_state == FC_DIRECTED ? "directed" : "full scan",
+		    wm_demo_boot_ms(BOOT_CONNECTED));
+		fc_state = FC_IDLE;
+	}
+
+	/* PSM writes are slow, keep them off the event thread */
+	wm_demo_wq_post(WQ_PRIO_LOW, fc_save, NULL);
+}
+
+static void fc_fallback(void *arg)
+{
+	app_sta_stop();
+	app_sta_start();
+}
+
+int hp_fast_reconnect_failed(void)
+{
+	if (fc_state != FC_DIRECTED)
+		return -WM_FAIL;
+
+	/* The AP may have moved or may still be booting. Keep the cache,
+	 * it is refreshed on the next successful connection anyway.
+	 */
+	dbg("Fast reconnect failed, falling back to full scan");
+	fc_state = FC_FULL_SCAN;
+	return wm_demo_wq_post(WQ_PRIO_HIGH, fc_fallback, NULL);
+}
+
+void hp_fast_reconnect_invalidate(void)
+{
+	fc_state = FC_IDLE;
+	psm_set_single(FC_MOD_NAME, VAR_FC_SSID, "");
+}
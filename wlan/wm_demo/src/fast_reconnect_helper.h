@@ -0,0 +1,38 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Fast reconnect
+ *
+ * The channel, BSSID and security type of the last AP we associated with
+ * are cached in PSM. At boot, the station first tries a directed connect
+ * on that channel and BSSID, which skips the full multi-channel scan. If
+ * that attempt fails, the station is restarted with the configured network
+ * as usual. The cache is kept, as the AP may only be booting, and is
+ * overwritten by the next successful connection.
+ */
+
+#ifndef _FAST_RECONNECT_HELPER_H_
+#define _FAST_RECONNECT_HELPER_H_
+
+/** Start the station interface. Uses the cached AP if there is one that
+ * matches the configured network, else falls back to app_sta_start().
+ */
+int hp_fast_reconnect_sta_start(void);
+
+/** To be called on AF_EVT_NORMAL_CONNECTED. Reports the time it took to
+ * connect and refreshes the cache (from the work queue).
+ */
+void hp_fast_reconnect_connected(void);
+
+/** To be called on AF_EVT_NORMAL_CONNECT_FAILED. If a directed connect
+ * was in progress, restarts the station with a full scan and returns
+ * WM_SUCCESS. Returns -WM_FAIL if the failure is left to the caller.
+ */
+int hp_fast_reconnect_failed(void);
+
+/** Forget the cached AP, e.g. on reset to provisioning */
+void hp_fast_reconnect_invalidate(void);
+
+#endif /* ! _FAST_RECONNECT_HELPER_H_ */
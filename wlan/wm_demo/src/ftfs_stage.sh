@@ -0,0 +1,216 @@
+#!/bin/sh
+# Copyright (C) 2008-2015, Marvell International Ltd.
+# All Rights Reserved.
+#
+# Stage the web application for the FTFS image
+#
+# Usage: ftfs_stage.sh <www dir> <staging dir>
+#
+# Files are copied from <www dir> to <staging dir>, except for:
+#
+# - the scripts and style sheets used by index.html, which are minified
+#   (if $JS_MINIFIER / $CSS_MINIFIER are set, e.g. to "uglifyjs -c -m"
+#   and "csso") and concatenated, in order, into bundle.js and bundle.css.
+#   index.html loads the bundles instead, with a ?v=<hash> suffix so that
+#   browsers can cache them for good: a new firmware with different
+#   content changes the URL;
+# - the signal strength images, merged into one sprite, signal.png (see
+#   png_sprite.py and .signal in custom.css);
+# - JavaScript and CSS files of GZ_MIN_SIZE bytes or more, which are stored
+#   gzip compressed only, as <name>.gz. Clients that do not accept gzip get
+#   406 Not Acceptable for them: there is no room for both copies.
+#
+# Every file is listed in assets.lst, one per line:
+#
+#   <uri> <ftfs file> <content type> <size> <etag> <gzip>
+#
+# where <etag> is derived from the MD5 of the stored content and <gzip> is
+# 1 if the file is stored compressed. The application serves these files
+# itself with ETag and Cache-Control headers.
+#
+# Needs python3, gzip, awk and md5sum (or md5 as on BSD/macOS).
+
+GZ_MIN_SIZE=1024
+MANIFEST=assets.lst
+# Order of the images in the sprite, as expected by custom.css
+SPRITE="signal0 signal0L signal1 signal1L signal2 signal2L signal3 signal3L"
+
+src=$1
+dst=$2
+
+if [ -z "$src" ] || [ -z "$dst" ] || [ ! -d "$src" ]; then
+	echo "Usage: $0 <www dir> <staging dir>" >&2
+	exit 1
+fi
+
+for tool in python3 gzip awk; do
+	if ! command -v $tool > /dev/null; then
+		echo "$0: $tool is needed to stage $src" >&2
+		exit 1
+	fi
+done
+if command -v md5sum > /dev/null; then
+	md5="md5sum"
+elif command -v md5 > /dev/null; then
+	md5="md5 -q"
+else
+	echo "$0: md5sum or md5 is needed to stage $src" >&2
+	exit 1
+fi
+
+content_type()
+{
+	case "$1" in
+	*.html)	echo "text/html" ;;
+	*.js)	echo "application/javascript" ;;
+	*.css)	echo "text/css" ;;
+	*.png)	echo "image/png" ;;
+	*.gif)	echo "image/gif" ;;
+	*.ico)	echo "image/x-icon" ;;
+	*)	echo "application/octet-stream" ;;
+	esac
+}
+
+etag()
+{
+	$md5 < "$1" | cut -c1-16
+}
+
+# add <uri> <ftfs file> <name> <gzip>
+add()
+{
+	size=`wc -c < "$dst/$2"`
+	echo "$1 $2 `content_type $3` $size `etag "$dst/$2"` $4" \
+		>> "$dst/$MANIFEST"
+}
+
+# Scripts or style sheets referenced by index.html, in order (POSIX sed)
+# refs <js|css>
+refs()
+{
+	[ -f "$src/index.html" ] || return
+	sed -n -e 's/.*src="\([^"/?:]*\.'$1'\)".*/\1/p' \
+		-e 's/.*href="\([^"/?:]*\.'$1'\)".*/\1/p' "$src/index.html"
+}
+
+# minify <file> <minifier command>
+minify()
+{
+	if [ -n "$2" ]; then
+		$2 "$1" || exit 1
+	else
+		cat "$1"
+	fi
+}
+
+# bundle <js|css> <minifier command>
+bundle()
+{
+	out="$dst/bundle.$1.tmp"
+	: > "$out"
+	for ref in `refs $1`; do
+		minify "$src/$ref" "$2" >> "$out"
+		# Guard against files without a trailing newline or ';'
+		if [ $1 = js ]; then
+			echo ";" >> "$out"
+		else
+			echo >> "$out"
+		fi
+	done
+}
+
+# stage <name> <path>
+stage()
+{
+	case "$1" in
+	*.js|*.css)
+		if [ `wc -c < "$2"` -ge $GZ_MIN_SIZE ]; then
+			# -n: no name/timestamp, for reproducible hashes
+			mkdir -p "$dst/`dirname $1`" || exit 1
+			gzip -9 -n -c "$2" > "$dst/$1.gz" || exit 1
+			add "/$1" "$1.gz" "$1" 1
+			return
+		fi ;;
+	esac
+
+	mkdir -p "$dst/`dirname $1`" || exit 1
+	[ "$2" = "$dst/$1" ] || cp "$2" "$dst/$1" || exit 1
+	add "/$1" "$1" "$1" 0
+}
+
+# Replace the first script or style sheet tag of index.html by the bundle
+# one and drop the others
+# bundle_html <js|css> <tag>
+bundle_html()
+{
+	awk -v refs="`echo \`refs $1\``" -v tag="$2" '
+		BEGIN {
+			n = split(refs, r, " ")
+			for (i = 1; i <= n; i++)
+				bundled[r[i]] = 1
+		}
+		{
+			if (match($0, /(src|href)="[^"]*"/)) {
+				ref = substr($0, RSTART, RLENGTH)
+				sub(/^(src|href)="/, "", ref)
+				sub(/"$/, "", ref)
+				if (ref in bundled) {
+					if (!done++)
+						print tag
+					next
+				}
+			}
+			print
+		}'
+}
+
+rm -rf "$dst"
+mkdir -p "$dst" || exit 1
+: > "$dst/$MANIFEST"
+
+bundled=" `echo \`refs js\` \`refs css\`` "
+sprite=""
+for img in $SPRITE; do
+	sprite="$sprite $src/$img.png"
+done
+
+# Subdirectories too, under their relative path
+for name in `cd "$src" && find . -type f | sed 's|^\./||' | sort`; do
+	f="$src/$name"
+
+	case "$bundled" in
+	*" $name "*)
+		continue ;;
+	esac
+	case "$sprite " in
+	*" $f "*)
+		continue ;;
+	esac
+	# Versioned last, once the hashes of the bundles are known
+	[ "$name" = index.html ] && continue
+
+	stage "$name" "$f"
+done
+
+python3 `dirname $0`/png_sprite.py "$dst/signal.png" $sprite || exit 1
+add "/signal.png" "signal.png" "signal.png" 0
+
+bundle js "$JS_MINIFIER"
+stage bundle.js "$dst/bundle.js.tmp"
+bundle css "$CSS_MINIFIER"
+stage bundle.css "$dst/bundle.css.tmp"
+rm -f "$dst"/bundle.*.tmp
+
+if [ -f "$src/index.html" ]; then
+	js_tag=`grep "^/bundle.js " "$dst/$MANIFEST" | cut -d' ' -f5`
+	css_tag=`grep "^/bundle.css " "$dst/$MANIFEST" | cut -d' ' -f5`
+	bundle_html css \
+		"<link rel=\"stylesheet\" href=\"bundle.css?v=$css_tag\" />" \
+		< "$src/index.html" > "$dst/index.tmp" || exit 1
+	bundle_html js \
+		"<script src=\"bundle.js?v=$js_tag\"></script>" \
+		< "$dst/index.tmp" > "$dst/index.html" || exit 1
+	rm -f "$dst/index.tmp"
+	add "/index.html" "index.html" "index.html" 0
+	add "/" "index.html" "index.html" 0
+fi
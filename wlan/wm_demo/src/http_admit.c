@@ -0,0 +1,309 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <wm_net.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <httpd.h>
+#include <cli.h>
+#include <http_admit.h>
+
+/* Tokens are counted in thousandths, one request takes a whole one */
+#define TOKEN		1000
+
+#define HTTP_RES_503_STR	"503 Service Unavailable"
+/* Most request data read and dropped to keep the connection usable */
+#define DRAIN_MAX		1024
+
+struct bucket {
+	int tokens;
+	unsigned long last;		/* ticks of the last refill */
+};
+
+struct client {
+	bool used;
+	uint32_t addr;			/* 0 if unknown */
+	struct bucket b;
+};
+
+static struct {
+	struct http_admit_cfg cfg;
+	struct client clients[HTTP_ADMIT_CLIENTS];
+	struct bucket global;
+	struct http_admit_stats st;
+} adm = {
+	.cfg = {
+		.client_rate = HTTP_ADMIT_CLIENT_RATE,
+		.client_burst = HTTP_ADMIT_CLIENT_BURST,
+		.global_rate = HTTP_ADMIT_GLOBAL_RATE,
+		.max_inflight = HTTP_ADMIT_MAX_INFLIGHT,
+	},
+};
+
+static os_mutex_t admit_mutex;
+
+int http_admit_init(void)
+{
+	if (admit_mutex)
+		return WM_SUCCESS;
+	return os_mutex_create(&admit_mutex, "http-admit", OS_MUTEX_INHERIT);
+}
+
+static void bucket_refill(struct bucket *b, int rate, int burst,
+			  unsigned long now)
+{
+	unsigned long ms = os_ticks_to_msec(now - b->last);
+
+	b->last = now;
+	/* Full after burst / rate seconds anyway, do not overflow */
+	if (ms >= (unsigned long)burst * TOKEN / rate)
+		b->tokens = burst * TOKEN;
+	else
+		b->tokens += ms * rate;
+	if (b->tokens > burst * TOKEN)
+		b->tokens = burst * TOKEN;
+}
+
+/* Seconds until the bucket has a token again */
+static int bucket_wait(const struct bucket *b, int rate)
+{
+	int ms = (TOKEN - b->tokens) / rate + 1;
+
+	return (ms + 999) / 1000;
+}
+
+/* The bucket of a client, a new full one if it was not known */
+static struct bucket *client_bucket(uint32_t addr, unsigned long now)
+{
+	struct client *c = NULL;
+	int i;
+
+	for (i = 0; i < HTTP_ADMIT_CLIENTS; i++) {
+		struct client *ci = &adm.clients[i];
+
+		if (ci->used && ci->addr == addr)
+			return &ci->b;
+		/* Replace a free slot, or else the least recently seen */
+		if (!c || (c->used && (!ci->used ||
+				       now - ci->b.last > now - c->b.last)))
+			c = ci;
+	}
+
+	if (c->used)
+		adm.st.evicted++;
+	c->used = true;
+	c->addr = addr;
+	c->b.tokens = adm.cfg.client_burst * TOKEN;
+	c->b.last = now;
+	return &c->b;
+}
+
+static uint32_t peer_addr(int sock)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+
+	if (getpeername(sock, (struct sockaddr *)&addr, &len) < 0)
+		return 0;
+	return addr.sin_addr.s_addr;
+}
+
+/* Read the rest of the request, so that the next one on a kept-alive
+ * connection is not parsed from its headers or data. Returns -WM_FAIL if
+ * that could not be done and the connection has to be closed.
+ */
+static int drain_request(httpd_request_t *req)
+{
+	char buf[64];
+	int n, left = DRAIN_MAX;
+
+	if (req->type != HTTP_POST && req->type != HTTP_PUT)
+		return httpd_purge_headers(req->sock) == WM_SUCCESS ?
+			WM_SUCCESS : -WM_FAIL;
+
+	do {
+		n = httpd_get_data(req, buf, sizeof(buf));
+		if (n < 0)
+			return -WM_FAIL;
+		left -= n;
+	} while (n > 0 && left > 0);
+	return req->remaining_bytes ? -WM_FAIL : WM_SUCCESS;
+}
+
+static void send_503(httpd_request_t *req, int retry_after)
+{
+	char val[12];
+	int sock = req->sock;
+
+	snprintf(val, sizeof(val), "%d", retry_after);
+	if (httpd_send(sock, "HTTP/1.1 " HTTP_RES_503_STR "\r\n",
+		       sizeof("HTTP/1.1 " HTTP_RES_503_STR "\r\n") - 1) !=
+	    WM_SUCCESS ||
+	    httpd_send_default_headers(sock, HTTPD_DEFAULT_HDR_FLAGS) !=
+	    WM_SUCCESS ||
+	    httpd_send_header(sock, "Retry-After", val) != WM_SUCCESS ||
+	    httpd_send_header(sock, "Content-Length", "0") != WM_SUCCESS)
+		return;
+	httpd_send_crlf(sock);
+}
+
+int http_admit_begin(httpd_request_t *req)
+{
+	uint32_t addr = peer_addr(req->sock);
+	unsigned long now = os_ticks_get();
+	struct bucket *b = NULL;
+	int retry = 0, ret;
+
+	os_mutex_get(&admit_mutex, OS_WAIT_FOREVER);
+
+	/* Cheapest check first, and no token taken for a busy server */
+	if (adm.cfg.max_inflight && adm.st.inflight >= adm.cfg.max_inflight) {
+		adm.st.rejected_busy++;
+		retry = 1;
+		goto out;
+	}
+
+	if (adm.cfg.client_rate) {
+		b = client_bucket(addr, now);
+		bucket_refill(b, adm.cfg.client_rate, adm.cfg.client_burst,
+			      now);
+		if (b->tokens < TOKEN) {
+			adm.st.rejected_client++;
+			retry = bucket_wait(b, adm.cfg.client_rate);
+			goto out;
+		}
+	}
+
+	/* The global bucket holds one second worth of requests */
+	if (adm.cfg.global_rate) {
+		bucket_refill(&adm.global, adm.cfg.global_rate,
+			      adm.cfg.global_rate, now);
+		if (adm.global.tokens < TOKEN) {
+			adm.st.rejected_global++;
+			retry = bucket_wait(&adm.global, adm.cfg.global_rate);
+			goto out;
+		}
+		adm.global.tokens -= TOKEN;
+	}
+
+	if (b)
+		b->tokens -= TOKEN;
+	adm.st.admitted++;
+	if (++adm.st.inflight > adm.st.inflight_max)
+		adm.st.inflight_max = adm.st.inflight;
+out:
+	os_mutex_put(&admit_mutex);
+
+	if (retry) {
+		ret = drain_request(req);
+		send_503(req, retry);
+		return ret == WM_SUCCESS ? -WM_E_BUSY : ret;
+	}
+	return WM_SUCCESS;
+}
+
+void http_admit_end(void)
+{
+	os_mutex_get(&admit_mutex, OS_WAIT_FOREVER);
+	adm.st.inflight--;
+	os_mutex_put(&admit_mutex);
+}
+
+int http_admit_call(httpd_request_t *req,
+		    int (*handler)(httpd_request_t *req))
+{
+	int ret;
+
+	ret = http_admit_begin(req);
+	if (ret != WM_SUCCESS)
+		return ret == -WM_E_BUSY ? WM_SUCCESS : ret;
+	ret = handler(req);
+	http_admit_end();
+	return ret;
+}
+
+void http_admit_get_cfg(struct http_admit_cfg *cfg)
+{
+	os_mutex_get(&admit_mutex, OS_WAIT_FOREVER);
+	*cfg = adm.cfg;
+	os_mutex_put(&admit_mutex);
+}
+
+int http_admit_set_cfg(const struct http_admit_cfg *cfg)
+{
+	if (cfg->client_rate < 0 || cfg->global_rate < 0 ||
+	    cfg->max_inflight < 0 ||
+	    (cfg->client_rate && cfg->client_burst < 1))
+		return -WM_E_INVAL;
+
+	os_mutex_get(&admit_mutex, OS_WAIT_FOREVER);
+	adm.cfg = *cfg;
+	/* Start over with full buckets */
+	memset(adm.clients, 0, sizeof(adm.clients));
+	adm.global.tokens = cfg->global_rate * TOKEN;
+	adm.global.last = os_ticks_get();
+	os_mutex_put(&admit_mutex);
+	return WM_SUCCESS;
+}
+
+void http_admit_get_stats(struct http_admit_stats *st)
+{
+	os_mutex_get(&admit_mutex, OS_WAIT_FOREVER);
+	*st = adm.st;
+	os_mutex_put(&admit_mutex);
+}
+
+static void admit_cmd(int argc, char **argv)
+{
+	struct http_admit_cfg cfg;
+	struct http_admit_stats st;
+
+	if (argc == 5) {
+		cfg.client_rate = atoi(argv[1]);
+		cfg.client_burst = atoi(argv[2]);
+		cfg.global_rate = atoi(argv[3]);
+		cfg.max_inflight = atoi(argv[4]);
+		if (http_admit_set_cfg(&cfg) != WM_SUCCESS) {
+			wmprintf("Invalid limits\r\n");
+			return;
+		}
+	} else if (argc != 1) {
+		wmprintf("Usage: %s [<client rate> <client burst> "
+			 "<global rate> <max inflight>]\r\n", argv[0]);
+		wmprintf("A rate or max inflight of 0 means no limit\r\n");
+		return;
+	}
+
+	http_admit_get_cfg(&cfg);
+	http_admit_get_stats(&st);
+	wmprintf("client %d/s burst %d, global %d/s, inflight %d max\r\n",
+		 cfg.client_rate, cfg.client_burst, cfg.global_rate,
+		 cfg.max_inflight);
+	wmprintf("admitted %u rejected: client %u global %u busy %u\r\n",
+		 st.admitted, st.rejected_client, st.rejected_global,
+		 st.rejected_busy);
+	wmprintf("inflight %d (max %d), evicted clients %u\r\n",
+		 st.inflight, st.inflight_max, st.evicted);
+}
+
+static struct cli_command admit_cmds[] = {
+	{"httpd-admit", "[<client rate> <burst> <global rate> <inflight>]",
+	 admit_cmd},
+};
+
+int http_admit_cli_init(void)
+{
+	int i;
+
+	/* Registered at boot, long before the WLAN and the handlers */
+	if (http_admit_init() != WM_SUCCESS)
+		return -WM_FAIL;
+	for (i = 0; i < sizeof(admit_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&admit_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
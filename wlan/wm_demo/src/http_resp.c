@@ -0,0 +1,217 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <httpd.h>
+#include <json.h>
+#include <http_resp.h>
+
+#define HTTP_RES_500_STR	"500 Internal Server Error"
+
+static char arenas[HTTP_RESP_ARENAS][HTTP_RESP_ARENA_LEN];
+static bool arena_used[HTTP_RESP_ARENAS];
+static os_mutex_t arena_mutex;
+
+int http_resp_init(void)
+{
+	if (arena_mutex)
+		return WM_SUCCESS;
+	return os_mutex_create(&arena_mutex, "http-resp", OS_MUTEX_INHERIT);
+}
+
+int http_resp_begin(struct http_resp *r, httpd_request_t *req,
+		    const char *type)
+{
+	int i;
+
+	memset(r, 0, sizeof(*r));
+	os_mutex_get(&arena_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < HTTP_RESP_ARENAS; i++) {
+		if (!arena_used[i]) {
+			arena_used[i] = true;
+			r->buf = arenas[i];
+			break;
+		}
+	}
+	os_mutex_put(&arena_mutex);
+	if (!r->buf)
+		return -WM_E_AGAIN;
+
+	r->req = req;
+	r->type = type;
+	r->top = HTTP_RESP_ARENA_LEN;
+	return WM_SUCCESS;
+}
+
+void http_resp_abort(struct http_resp *r)
+{
+	if (!r->buf)
+		return;
+	os_mutex_get(&arena_mutex, OS_WAIT_FOREVER);
+	arena_used[(r->buf - arenas[0]) / HTTP_RESP_ARENA_LEN] = false;
+	os_mutex_put(&arena_mutex);
+	r->buf = NULL;
+}
+
+void *http_resp_alloc(struct http_resp *r, int size)
+{
+	size = (size + 3) & ~3;
+	if (r->top - size < r->len)
+		return NULL;
+	r->top -= size;
+	return r->buf + r->top;
+}
+
+static int resp_error(struct http_resp *r, int err)
+{
+	if (!r->err)
+		r->err = err;
+	return err;
+}
+
+/* Send the body built so far as a chunk, starting a chunked response */
+static int resp_flush(struct http_resp *r)
+{
+	int sock = r->req->sock;
+	char line[32];
+	int n;
+
+	if (r->err)
+		return r->err;
+
+	if (!r->chunked) {
+		n = snprintf(line, sizeof(line), "HTTP/1.1 %s\r\n",
+			     HTTP_RES_200);
+		if (httpd_send(sock, line, n) != WM_SUCCESS ||
+		    httpd_send_default_headers(sock, HTTPD_DEFAULT_HDR_FLAGS)
+		    != WM_SUCCESS ||
+		    httpd_send_header(sock, "Content-Type", r->type) !=
+		    WM_SUCCESS ||
+		    httpd_send_header(sock, "Transfer-Encoding", "chunked") !=
+		    WM_SUCCESS ||
+		    httpd_send_crlf(sock) != WM_SUCCESS)
+			return resp_error(r, -WM_FAIL);
+		r->chunked = true;
+	}
+
+	if (r->len && httpd_send_chunk(sock, r->buf, r->len) != WM_SUCCESS)
+		return resp_error(r, -WM_FAIL);
+	r->len = 0;
+	return WM_SUCCESS;
+}
+
+int http_resp_append(struct http_resp *r, const char *data, int len)
+{
+	int n;
+
+	while (len > 0) {
+		if (r->len == r->top && resp_flush(r) != WM_SUCCESS)
+			return r->err;
+		n = r->top - r->len;
+		if (n == 0)
+			/* All taken by scratch allocations */
+			return resp_error(r, -WM_E_NOMEM);
+		if (n > len)
+			n = len;
+		memcpy(r->buf + r->len, data, n);
+		r->len += n;
+		data += n;
+		len -= n;
+	}
+	return r->err;
+}
+
+int http_resp_printf(struct http_resp *r, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (r->err)
+		return r->err;
+
+	va_start(ap, fmt);
+	n = vsnprintf(r->buf + r->len, r->top - r->len, fmt, ap);
+	va_end(ap);
+	if (n >= 0 && n < r->top - r->len) {
+		r->len += n;
+		return WM_SUCCESS;
+	}
+
+	/* Retry in an empty buffer */
+	if (!r->len)
+		return resp_error(r, -WM_E_NOMEM);
+	if (resp_flush(r) != WM_SUCCESS)
+		return r->err;
+	va_start(ap, fmt);
+	n = vsnprintf(r->buf, r->top, fmt, ap);
+	va_end(ap);
+	if (n < 0 || n >= r->top)
+		return resp_error(r, -WM_E_NOMEM);
+	r->len = n;
+	return WM_SUCCESS;
+}
+
+struct json_str *http_resp_json_begin(struct http_resp *r)
+{
+	/* Give the document as much room as possible */
+	if (r->len && r->top - r->len < HTTP_RESP_ARENA_LEN / 2)
+		resp_flush(r);
+
+	r->json_start = r->len;
+	json_str_init(&r->jstr, r->buf + r->len, r->top - r->len, 0);
+	return &r->jstr;
+}
+
+int http_resp_json_end(struct http_resp *r)
+{
+	int n = strlen(r->buf + r->json_start);
+
+	/* The json_* functions stop one byte short of the end when full */
+	if (n >= r->top - r->json_start - 1)
+		return resp_error(r, -WM_E_NOMEM);
+	r->len = r->json_start + n;
+	return r->err;
+}
+
+int http_resp_get_json(struct http_resp *r, struct json_object *obj,
+		       int maxlen)
+{
+	char *data = http_resp_alloc(r, maxlen);
+
+	if (!data)
+		return -WM_E_NOMEM;
+	return httpd_get_data_json(r->req, data, maxlen, obj);
+}
+
+int http_resp_send(struct http_resp *r, const char *status)
+{
+	int ret;
+
+	if (r->err && !r->chunked) {
+		/* Nothing went out yet, do not leave the client waiting */
+		ret = httpd_send_response(r->req, HTTP_RES_500_STR, "", 0,
+					  HTTP_CONTENT_PLAIN_TEXT_STR);
+		if (ret == WM_SUCCESS)
+			ret = r->err;
+	} else if (r->err) {
+		/* Past the headers: the connection is closed on the error,
+		 * the client sees the body cut short
+		 */
+		ret = r->err;
+	} else if (r->chunked) {
+		ret = resp_flush(r);
+		if (ret == WM_SUCCESS)
+			ret = httpd_send_chunk(r->req->sock, NULL, 0);
+	} else {
+		ret = httpd_send_response(r->req, status, r->buf, r->len,
+					  r->type);
+	}
+
+	http_resp_abort(r);
+	return ret;
+}
@@ -3,121 +3,380 @@
  *  All Rights Reserved.
  */
 
+/* LED pattern engine
+ *
+ * All the LEDs are driven from one timer, created once. Each time it
+ * fires, the patterns are moved on to the current time, the LEDs set and
+ * the timer programmed for the next step that changes what is shown. It is
+ * stopped while nothing changes (LEDs steady on or off, or dimmed by the
+ * PWM hardware), and runs every LED_PWM_TICK_MS only while an LED without
+ * hardware PWM is at an intermediate level and software PWM is allowed.
+ */
+
 #include <wmstdio.h>
 #include <wm_os.h>
 #include <board.h>
 #include <led_indicator.h>
+#include <led_pwm.h>
 
 /*-----------------------Global declarations----------------------*/
+struct led_slot {
+	const struct led_step *steps;
+	uint8_t nsteps;
+	uint8_t step;
+	uint8_t repeat;			/* left, 0 for ever */
+	bool active;
+	unsigned long step_end;		/* ticks */
+};
+
 struct led_private_data {
-	uint8_t led_no;
-	uint8_t curr_state;
-	os_timer_t timer;
-	int on_duty_cycle;
-	int off_duty_cycle;
-} led_data[LED_COUNT];
+	int led_no;			/* -1 if unused */
+	bool hw;			/* dimmed by hardware PWM */
+	bool lit;			/* pin state */
+	uint8_t level;			/* to show */
+	uint8_t hw_level;		/* set in the PWM hardware */
+	struct led_slot slot[LED_PRIO_COUNT];
+	/* Steps of led_on(), led_level() and led_blink() */
+	struct led_step base[2];
+	/* Steps of led_breathe() */
+	struct led_step ramp[2 * LED_BREATHE_STEPS];
+};
+
+/* Perceived brightness grows about with the square of the duty cycle */
+static const uint8_t breathe_curve[LED_BREATHE_STEPS] = {
+	0, 1, 3, 5, 8, 12, 16, 22, 28, 36, 44, 53, 63, 75, 87, 100,
+};
+
+static struct led_private_data led_data[LED_COUNT];
+static os_timer_t led_timer;
+static os_mutex_t led_mutex;
+static uint8_t pwm_phase;
+static volatile bool sw_pwm = true;
+static bool led_ready;
+
+static void led_cb(os_timer_arg_t handle);
 
-static int decide_led_array_index(int led_no)
+int led_indicator_init(void)
+{
+	int i, ret;
+
+	if (led_ready)
+		return WM_SUCCESS;
+
+	for (i = 0; i < LED_COUNT; i++)
+		led_data[i].led_no = -1;
+
+	ret = os_mutex_create(&led_mutex, "led", OS_MUTEX_INHERIT);
+	if (ret != WM_SUCCESS)
+		return ret;
+	ret = os_timer_create(&led_timer, "led-timer",
+			      os_msec_to_ticks(LED_PWM_TICK_MS), led_cb, NULL,
+			      OS_TIMER_ONE_SHOT, OS_TIMER_NO_ACTIVATE);
+	if (ret != WM_SUCCESS) {
+		os_mutex_delete(&led_mutex);
+		return ret;
+	}
+	led_ready = true;
+	return WM_SUCCESS;
+}
+
+static struct led_private_data *led_find(int led_no)
 {
 	int i;
+
+	if (!led_ready && led_indicator_init() != WM_SUCCESS)
+		return NULL;
+
+	os_mutex_get(&led_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < LED_COUNT; i++)
+		if (led_data[i].led_no == led_no)
+			goto out;
 	for (i = 0; i < LED_COUNT; i++) {
-		if (led_data[i].led_no == led_no) {
-			return i;
-		} else if (led_data[i].led_no == 0) {
+		if (led_data[i].led_no == -1) {
 			led_data[i].led_no = led_no;
-			return i;
+			led_data[i].hw = led_pwm_init(led_no) == WM_SUCCESS;
+			board_led_off(led_no);
+			goto out;
 		}
 	}
-	return -WM_FAIL;
+out:
+	os_mutex_put(&led_mutex);
+	return i < LED_COUNT ? &led_data[i] : NULL;
 }
 
-void led_on(int led_no)
+/* Move to the step running at now. A slot that is not shown is caught up
+ * with the next time it is looked at: whole rounds missed are skipped in
+ * one go, then the steps of the last one are walked.
+ */
+static void slot_advance(struct led_slot *s, unsigned long now)
 {
-	int idx = decide_led_array_index(led_no);
-	int ret;
+	unsigned long round = 0, n;
+	int i;
 
-	if (idx == -WM_FAIL)
+	if (!s->active || !s->steps[s->step].ms ||
+	    (long)(now - s->step_end) < 0)
 		return;
 
-	if (os_timer_is_active(&led_data[idx].timer) == WM_SUCCESS) {
-		ret = os_timer_delete(&led_data[idx].timer);
-		if (ret != WM_SUCCESS) {
-			wmprintf("Unable to delete LED timer\n\r");
+	for (i = 0; i < s->nsteps && s->steps[i].ms; i++)
+		round += os_msec_to_ticks(s->steps[i].ms);
+	/* A step held for ever ends the walk within one round */
+	if (i == s->nsteps && round && now - s->step_end >= round) {
+		n = (now - s->step_end) / round;
+		if (s->repeat && n >= s->repeat) {
+			s->active = false;
 			return;
 		}
+		if (s->repeat)
+			s->repeat -= n;
+		s->step_end += n * round;
+	}
+
+	while (s->active && s->steps[s->step].ms &&
+	       (long)(now - s->step_end) >= 0) {
+		if (++s->step == s->nsteps) {
+			s->step = 0;
+			if (s->repeat && --s->repeat == 0) {
+				s->active = false;
+				break;
+			}
+		}
+		s->step_end += os_msec_to_ticks(s->steps[s->step].ms);
 	}
-	led_data[idx].curr_state = LED_ON;
-	board_led_on(led_no);
 }
 
-void led_off(int led_no)
+/* Level of the software PWM: anything lit shows at least one */
+static int sw_level(int level)
 {
-	int idx = decide_led_array_index(led_no);
-	int err;
+	return (level * LED_SW_LEVELS + LED_LEVEL_MAX - 1) / LED_LEVEL_MAX;
+}
 
-	if (idx == -WM_FAIL)
+/* The hardware runs only for the levels in between */
+static void led_output_hw(struct led_private_data *l)
+{
+	if (l->level == l->hw_level)
 		return;
-	if (os_timer_is_active(&led_data[idx].timer) == WM_SUCCESS) {
-		err = os_timer_delete(&led_data[idx].timer);
-		if (err != WM_SUCCESS) {
-			wmprintf("Unable to delete LED timer\n\r");
-			return;
+	if (l->level && l->level < LED_LEVEL_MAX &&
+	    led_pwm_set(l->led_no, l->level) == WM_SUCCESS) {
+		l->hw_level = l->level;
+		return;
+	}
+	led_pwm_stop(l->led_no);
+	if (l->level)
+		board_led_on(l->led_no);
+	else
+		board_led_off(l->led_no);
+	l->lit = l->level != 0;
+	l->hw_level = l->level;
+}
+
+static void led_output(struct led_private_data *l)
+{
+	int level = sw_level(l->level);
+	bool lit;
+
+	if (l->hw) {
+		led_output_hw(l);
+		return;
+	}
+	lit = level >= LED_SW_LEVELS || (level && (!sw_pwm ||
+						   pwm_phase < level));
+	if (lit == l->lit)
+		return;
+	if (lit)
+		board_led_on(l->led_no);
+	else
+		board_led_off(l->led_no);
+	l->lit = lit;
+}
+
+/* Show the patterns as of now and program the timer. Called with
+ * led_mutex held.
+ */
+static void led_update(void)
+{
+	unsigned long now = os_ticks_get(), wait = 0;
+	struct led_private_data *l;
+	struct led_slot *s;
+	bool pwm = false;
+	int i, p;
+
+	pwm_phase = (pwm_phase + 1) % LED_SW_LEVELS;
+
+	for (i = 0; i < LED_COUNT; i++) {
+		l = &led_data[i];
+		if (l->led_no == -1)
+			continue;
+
+		l->level = 0;
+		for (p = LED_PRIO_COUNT - 1; p >= 0; p--) {
+			s = &l->slot[p];
+			slot_advance(s, now);
+			if (!s->active)
+				continue;
+			l->level = s->steps[s->step].level;
+			if (s->steps[s->step].ms &&
+			    (!wait || s->step_end - now < wait))
+				wait = s->step_end - now;
+			break;
 		}
+		if (sw_pwm && !l->hw && l->level &&
+		    sw_level(l->level) < LED_SW_LEVELS)
+			pwm = true;
+		led_output(l);
+	}
+
+	if (pwm && (!wait || wait > os_msec_to_ticks(LED_PWM_TICK_MS)))
+		wait = os_msec_to_ticks(LED_PWM_TICK_MS);
+
+	if (!wait) {
+		os_timer_deactivate(&led_timer);
+		return;
 	}
-	led_data[idx].curr_state = LED_OFF;
-	board_led_off(led_no);
+	/* Never wait for the timer queue: its task may want the mutex */
+	os_timer_change(&led_timer, wait, 0);
+	os_timer_activate(&led_timer);
 }
 
+/* Runs in the timer task, which must not wait: if the mutex is taken,
+ * try again on the next tick.
+ */
 static void led_cb(os_timer_arg_t handle)
 {
-	int tid = (int) os_timer_get_context(&handle);
-	if (tid >= LED_COUNT) {
+	if (os_mutex_get(&led_mutex, OS_NO_WAIT) != WM_SUCCESS) {
+		os_timer_change(&led_timer, 1, 0);
+		os_timer_activate(&led_timer);
 		return;
 	}
-	if (led_data[tid].curr_state == LED_ON) {
-		board_led_off(led_data[tid].led_no);
-		led_data[tid].curr_state = LED_OFF;
-		os_timer_change(&led_data[tid].timer,
-				led_data[tid].off_duty_cycle, -1);
-		os_timer_activate(&led_data[tid].timer);
-	} else {
-		board_led_on(led_data[tid].led_no);
-		led_data[tid].curr_state = LED_ON;
-		os_timer_change(&led_data[tid].timer,
-				led_data[tid].on_duty_cycle, -1);
-		os_timer_activate(&led_data[tid].timer);
+	led_update();
+	os_mutex_put(&led_mutex);
+}
+
+void led_sw_pwm_allow(bool allow)
+{
+	if (sw_pwm == allow)
+		return;
+	sw_pwm = allow;
+	/* Shown from the timer, so that this never waits */
+	if (led_ready) {
+		os_timer_change(&led_timer, 1, 0);
+		os_timer_activate(&led_timer);
 	}
 }
 
-void led_blink(int led_no, int on_duty_cycle, int off_duty_cycle)
+static void slot_start(struct led_slot *s, const struct led_step *steps,
+		       int nsteps, int repeat)
+{
+	s->steps = steps;
+	s->nsteps = nsteps;
+	s->step = 0;
+	s->repeat = repeat;
+	s->step_end = os_ticks_get() + os_msec_to_ticks(steps[0].ms);
+	s->active = true;
+}
+
+int led_pattern_start(int led_no, const struct led_pattern *p,
+		      enum led_prio prio)
 {
-	int err, idx;
+	struct led_private_data *l;
+
+	if (!p->nsteps || prio >= LED_PRIO_COUNT)
+		return -WM_E_INVAL;
 
-	idx = decide_led_array_index(led_no);
+	l = led_find(led_no);
+	if (!l)
+		return -WM_FAIL;
 
-	if (idx == -WM_FAIL)
+	os_mutex_get(&led_mutex, OS_WAIT_FOREVER);
+	slot_start(&l->slot[prio], p->steps, p->nsteps, p->repeat);
+	led_update();
+	os_mutex_put(&led_mutex);
+	return WM_SUCCESS;
+}
+
+void led_pattern_stop(int led_no, enum led_prio prio)
+{
+	struct led_private_data *l = led_find(led_no);
+
+	if (!l || prio >= LED_PRIO_COUNT)
 		return;
 
-	if (os_timer_is_active(&led_data[idx].timer) == WM_SUCCESS) {
-		err = os_timer_delete(&led_data[idx].timer);
-		if (err != WM_SUCCESS) {
-			return;
-		}
+	os_mutex_get(&led_mutex, OS_WAIT_FOREVER);
+	l->slot[prio].active = false;
+	led_update();
+	os_mutex_put(&led_mutex);
+}
+
+int led_breathe(int led_no, int period_ms, enum led_prio prio)
+{
+	struct led_private_data *l;
+	int i, ms = period_ms / (2 * LED_BREATHE_STEPS);
+
+	if (ms <= 0 || ms > 0xffff || prio >= LED_PRIO_COUNT)
+		return -WM_E_INVAL;
+
+	l = led_find(led_no);
+	if (!l)
+		return -WM_FAIL;
+
+	os_mutex_get(&led_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < LED_PRIO_COUNT; i++)
+		if (l->slot[i].steps == l->ramp)
+			l->slot[i].active = false;
+	for (i = 0; i < LED_BREATHE_STEPS; i++) {
+		l->ramp[i].ms = ms;
+		l->ramp[i].level = breathe_curve[i];
+		l->ramp[2 * LED_BREATHE_STEPS - 1 - i].ms = ms;
+		l->ramp[2 * LED_BREATHE_STEPS - 1 - i].level =
+			breathe_curve[i];
 	}
-	led_data[idx].on_duty_cycle = on_duty_cycle;
-	led_data[idx].off_duty_cycle = off_duty_cycle;
-
-	board_led_off(led_no);
-	led_data[idx].curr_state = LED_OFF;
-
-	err = os_timer_create(&led_data[idx].timer,
-			      "led-timer",
-			      os_msec_to_ticks(led_data[idx].on_duty_cycle),
-			      led_cb,
-			      (void *)idx,
-			      OS_TIMER_ONE_SHOT,
-			      OS_TIMER_AUTO_ACTIVATE);
-	if (err != WM_SUCCESS) {
+	slot_start(&l->slot[prio], l->ramp, 2 * LED_BREATHE_STEPS, 0);
+	led_update();
+	os_mutex_put(&led_mutex);
+	return WM_SUCCESS;
+}
+
+/* Base priority: the steps live in the LED data */
+static void led_base(int led_no, int on_ms, int on_level, int off_ms)
+{
+	struct led_private_data *l = led_find(led_no);
+
+	if (!l)
 		return;
-	}
+
+	os_mutex_get(&led_mutex, OS_WAIT_FOREVER);
+	l->base[0].ms = on_ms;
+	l->base[0].level = on_level;
+	l->base[1].ms = off_ms;
+	l->base[1].level = 0;
+	slot_start(&l->slot[LED_PRIO_BASE], l->base, off_ms ? 2 : 1, 0);
+	led_update();
+	os_mutex_put(&led_mutex);
+}
+
+void led_on(int led_no)
+{
+	led_base(led_no, 0, LED_LEVEL_MAX, 0);
+}
+
+void led_off(int led_no)
+{
+	led_pattern_stop(led_no, LED_PRIO_BASE);
+}
+
+void led_level(int led_no, int level)
+{
+	if (level <= 0)
+		led_off(led_no);
+	else
+		led_base(led_no, 0, level < LED_LEVEL_MAX ?
+			 level : LED_LEVEL_MAX, 0);
+}
+
+void led_blink(int led_no, int on_duty_cycle, int off_duty_cycle)
+{
+	/* A step lasts at most 0xffff ms */
+	if (on_duty_cycle <= 0 || off_duty_cycle <= 0 ||
+	    on_duty_cycle > 0xffff || off_duty_cycle > 0xffff)
+		return;
+	led_base(led_no, on_duty_cycle, LED_LEVEL_MAX, off_duty_cycle);
 }
@@ -6,21 +6,93 @@
 #ifndef __LED_INDICATOR__
 #define __LED_INDICATOR__
 
+#include <wmtypes.h>
+
 #define LED_COUNT 2
 enum led_state {
 	LED_OFF = 0,
 	LED_ON,
 };
 
+/* Brightness levels, in percent. LEDs on a pin with a hardware PWM
+ * output (see led_pwm.c) are dimmed by the timer hardware. On the others,
+ * levels in between are rounded up to one of LED_SW_LEVELS and done in
+ * software, one level per LED_PWM_TICK_MS, or shown full on while
+ * software PWM is not allowed (see led_sw_pwm_allow()).
+ */
+#define LED_LEVEL_MAX		100
+#define LED_SW_LEVELS		4
+#define LED_PWM_TICK_MS		2
+
+/* Breathing: steps up and as many down, every period / (2 * steps) */
+#define LED_BREATHE_STEPS	16
+
+/* Patterns of higher priority take over the LED while they run. Once one
+ * ends or is stopped, the LED shows the next one down again: lower
+ * priority patterns keep running underneath.
+ */
+enum led_prio {
+	LED_PRIO_BASE = 0,	/* led_on(), led_off(), led_blink() */
+	LED_PRIO_NOTIFY,
+	LED_PRIO_ERROR,
+	LED_PRIO_COUNT,
+};
+
+/* A step holds a level for ms milliseconds. A step of 0 ms holds its
+ * level until the pattern is replaced or stopped.
+ */
+struct led_step {
+	uint16_t ms;
+	uint8_t level;
+};
+
+struct led_pattern {
+	const struct led_step *steps;
+	uint8_t nsteps;
+	uint8_t repeat;		/* times through the steps, 0 for ever */
+};
+
+/** Create the timer driving all the LEDs. Called by the first LED
+ * function if not done before; no timer is created or deleted after that.
+ */
+int led_indicator_init(void);
+
+/** Run a pattern on an LED at a priority, in place of any pattern running
+ * there at that priority. The pattern is used in place and must stay
+ * valid while it runs.
+ */
+int led_pattern_start(int led_no, const struct led_pattern *p,
+		      enum led_prio prio);
+
+/** Stop the pattern running on an LED at a priority */
+void led_pattern_stop(int led_no, enum led_prio prio);
+
+/** Make an LED breathe, fading in and out over period_ms, at a priority.
+ * An LED has room for one breathing pattern: starting one stops the
+ * previous one.
+ */
+int led_breathe(int led_no, int period_ms, enum led_prio prio);
+
+/** Allow or not the software PWM, allowed by default. It wakes the CPU
+ * every LED_PWM_TICK_MS while an LED without hardware PWM is dimmed:
+ * power management turns it off while the core may enter PM2. Does not
+ * wait, can be called from a PM callback.
+ */
+void led_sw_pwm_allow(bool allow);
+
 /** Switch ON LED */
 void led_on(int led_no);
 
 /** Switch OFF LED */
 void led_off(int led_no);
 
+/** Light the LED at a brightness level, 0 to LED_LEVEL_MAX */
+void led_level(int led_no, int level);
+
 /** Blink the LED
  * on_duty_cycle : time in milisec for which LED will be ON in blinking cycle
  * off_duty_cycle : time in milisec for which LED will be OFF in blinking cycle
+ * Both from 1 to 65535, the LED is left as it is otherwise.
  */
 void led_blink(int led_no, int on_duty_cycle, int off_duty_cycle);
 
@@ -0,0 +1,32 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Hardware PWM backend of the LED pattern engine
+ *
+ * LEDs on a pin that can be routed to a GPT channel output are dimmed by
+ * the timer hardware: a level is set once and held with no CPU
+ * involvement, so the core can stay in PM2. Pins are looked up in the
+ * board table of led_pwm.c, which has no entry for the boards shipped;
+ * the other LEDs are dimmed in software by led_indicator.c.
+ */
+
+#ifndef __LED_PWM__
+#define __LED_PWM__
+
+/* PWM period, in GPT driver units (microseconds): 1 kHz */
+#define LED_PWM_PERIOD		1000
+
+/** Prepare the GPT channel of pin. Returns -WM_FAIL if pin has none. */
+int led_pwm_init(int pin);
+
+/** Drive pin from its GPT channel at level, 1 to LED_LEVEL_MAX - 1 */
+int led_pwm_set(int pin, int level);
+
+/** Stop the GPT channel of pin and give the pin back to the GPIO function.
+ * The LED must then be set with board_led_on() or board_led_off().
+ */
+void led_pwm_stop(int pin);
+
+#endif /* ! __LED_PWM__ */
@@ -78,6 +78,7 @@
 #include <mdns_helper.h>
 #include <wps_helper.h>
 #include <reset_prov_helper.h>
+#include <fast_reconnect_helper.h>
 #include <power_mgr_helper.h>
 #include <httpd.h>
 #include <wmcloud.h>
@@ -91,11 +92,26 @@
 #include <diagnostics.h>
 #include <mdev_gpio.h>
 #include <mdev_pinmux.h>
+#include <gpio_fast.h>
 
 #include <healthmon.h>
 #include "wm_demo_cloud.h"
 #include "wm_demo_wps_cli.h"
 #include <wm_demo_overlays.h>
+#include <wm_demo_props.h>
+#include <wm_demo_msg.h>
+#include <wm_demo_wq.h>
+#include <wm_demo_boot.h>
+#include <wm_demo_chan.h>
+#include <wm_demo_assets.h>
+#include <wm_demo_events.h>
+#include <wm_demo_scan.h>
+#include <wm_demo_http.h>
+#include <wm_demo_lan.h>
+#include <wm_demo_pm.h>
+#include <wm_demo_netsched.h>
+#include <wake_audit.h>
+#include <http_admit.h>
 
 
 /*-----------------------Global declarations----------------------*/
@@ -111,11 +127,14 @@ char *ftfs_part_name = "ftfs";
 
 struct fs *fs;
 
-static os_timer_t uap_down_timer;
-
 #define UAP_DOWN_TIMEOUT (30 * 1000)
+/* Wait after a failed connection attempt before the next one */
+#define CONN_RETRY_MS		2000
 
 #define NETWORK_MOD_NAME	"network"
+
+/* Device channel server */
+#define WM_DEMO_CHAN_URL	"192.168.0.19:8089"
 #define VAR_UAP_SSID		"uap_ssid"
 #define VAR_PROV_KEY            "prov_key"
 //#define APPCONFIG_PROV_EZCONNECT
@@ -131,21 +150,22 @@ static os_thread_t app_thread_http_listen;
 
 /* Buffer to be used as stack */
 static os_thread_stack_define(app_stack_button, 1024);
+/* Only reads and decodes: the channel session is opened, and reported to,
+ * from the work queue
+ */
 static os_thread_stack_define(app_stack_http_listen, 1024);
 
 extern cloud_t c;
 
-static struct json_str jstr;
-static struct json_object obj;
-
 
 /** Provisioning done timer call back function
  * Once the provisioning is done, we wait for provisioning client to send
  * AF_EVT_PROV_CLIENT_DONE which stops uap and dhcp server. But if any case
  * client doesn't send AF_EVT_PROV_CLIENT_DONE event, then we wait for
- * 60seconds(timer) to shutdown UAP.
+ * 60seconds(timer) to shutdown UAP. The deannouncement may go out up to
+ * 5 seconds early, along with other traffic.
  */
-static void uap_down_timer_cb(os_timer_arg_t arg)
+static void uap_down_timer_cb(void *arg)
 {
 	if (is_uap_started()) {
 		hp_mdns_deannounce(net_get_uap_handle());
@@ -153,6 +173,13 @@ static void uap_down_timer_cb(os_timer_arg_t arg)
 	}
 }
 
+static struct netsched_job uap_down_job = {
+	.name = "uap-down",
+	.fn = uap_down_timer_cb,
+	.slack_ms = 5000,
+	.late = true,
+};
+
 /* This function initializes the SSID with the PSM variable network.uap_ssid
  * If the variable is not found, the default value is used.
  * To change the ssid, please set the network.uap_ssid variable
@@ -207,84 +234,6 @@ int wmdemo_get_prov_key(uint8_t *prov_key)
 	}
 }
 
-/*
- * A simple HTTP Web-Service Handler
- *
- * Returns the string "Hello World" when a GET on http://<IP>/hello
- * is done.
- */
-
-char *hello_world_string = "Hello World\n";
-
-int hello_handler(httpd_request_t *req)
-{
-	char *content = hello_world_string;
-	uint8_t my_mac[6];
-	wlan_get_mac_address(my_mac);
-	char deviceName[23];
-	char buff[128];
-	json_str_init(&jstr,buff,sizeof(buff),0);
-	json_start_object(&jstr);
-	
-	snprintf(deviceName, sizeof(deviceName),
-							 "ck00345678%02X%02X%02X%02X%02X%02X", my_mac[0], my_mac[1],my_mac[2], my_mac[3],my_mac[4], my_mac[5]);
-	json_set_val_str(&jstr,"snId",deviceName);
-	json_close_object(&jstr);			
-	httpd_send_response(req, HTTP_RES_200,
-			    buff, strlen(buff),
-			    HTTP_CONTENT_PLAIN_TEXT_STR);
-	return WM_SUCCESS;
-}
-
-static int wm_demo_get_ui_link(httpd_request_t *req)
-{
-	return cloud_get_ui_link(req);
-}
-
-int set_dev_seckey(httpd_request_t *req)
-{
-	char http_dev_seckey[64];
-	char dev_seckey[64];
-	int ret;
-
-	ret = httpd_get_data_json(req, http_dev_seckey,
-			sizeof(http_dev_seckey), &obj);
-	//ret = httpd_get_data(req, http_dev_session_key,
-			//sizeof(http_dev_session_key));
-	if (ret < 0) {
-		dbg("Failed to get post request data");
-		return ret;
-	}
-	dbg("http get : %s",http_dev_seckey);
-	if (json_get_val_str(&obj, "secKey",dev_seckey,sizeof(dev_seckey)) != WM_SUCCESS)
-	{
-		ret = httpd_send_response(req, HTTP_RES_200, HTTPD_JSON_ERROR,
-			strlen(HTTPD_JSON_ERROR), HTTP_CONTENT_JSON_STR);
-		
-	}		
-	else
-	{
-		ret = httpd_send_response(req, HTTP_RES_200, HTTPD_JSON_SUCCESS,
-			strlen(HTTPD_JSON_SUCCESS), HTTP_CONTENT_JSON_STR);
-		dbg("recvd seckey is %s",dev_seckey);
-		hp_mdns_deannounce(net_get_uap_handle());
-	}
-	return ret;			
-
-}
-
-
-struct httpd_wsgi_call wm_demo_http_handlers[] = {
-	{"/hello", HTTPD_DEFAULT_HDR_FLAGS, 0,
-	hello_handler, set_dev_seckey, NULL, NULL},
-	{"/cloud_ui", HTTPD_DEFAULT_HDR_FLAGS | HTTPD_HDR_ADD_PRAGMA_NO_CACHE,
-	0, wm_demo_get_ui_link, NULL, NULL, NULL},
-};
-
-static int wm_demo_handlers_no =
-	sizeof(wm_demo_http_handlers) / sizeof(struct httpd_wsgi_call);
-
-
 /* This function is defined for handling critical error.
  * For this application, we just stall and do nothing when
  * a critical error occurs.
@@ -297,15 +246,6 @@ void appln_critical_error_handler(void *data)
 	/* do nothing -- stall */
 }
 
-/*
- * Register Web-Service handlers
- *
- */
-int register_httpd_handlers()
-{
-	return httpd_register_wsgi_handlers(wm_demo_http_handlers,
-		wm_demo_handlers_no);
-}
 
 /* This function must initialize the variables required (network name,
  * passphrase, etc.) It should also register all the event handlers that are of
@@ -320,6 +260,8 @@ int appln_config_init()
 	appln_cfg.reset_prov_pb_gpio = board_button_3();
 	/* Initialize power management */
 	hp_pm_init();
+	if (wm_demo_pm_init() != WM_SUCCESS)
+		dbg("Error: power state accounting init failed");
 	return 0;
 }
 
@@ -327,50 +269,56 @@ int appln_config_init()
 static int provisioned;
 static uint8_t mdns_announced;
 
+/* The event stream, the scan cache and local control only serve clients
+ * on the local network. With APPCONFIG_DEFER_LOCAL they are started after
+ * the first connection instead of at WLAN init, or when provisioning
+ * starts. Event handlers only, each step is done once.
+ */
+static void start_local_servers()
+{
+	static bool started;
+
+	if (started)
+		return;
+	started = true;
+
+	/* Push state changes to local clients */
+	if (wm_demo_events_init() != WM_SUCCESS)
+		dbg("Error: Failed to start the event stream");
+
+	/* Local control over UDP, independent of the cloud */
+	if (wm_demo_lan_init() != WM_SUCCESS)
+		dbg("Error: Failed to start local control");
+
+	/* Answer /sys/scan from a cache, ahead of the provisioning module */
+	if (wm_demo_scan_init() != WM_SUCCESS)
+		dbg("Error: Failed to register the scan cache");
+
+	wm_demo_boot_mark("local-servers");
+}
+
 /* This function stops various services when
  * device gets disconnected or reset to provisioning is done.
  */
 static void stop_services()
 {
 	wm_demo_cloud_stop();
+	wm_demo_chan_stop();
 	led_off(board_led_1());
 }
 
 /* This function starts various services when
  * device get connected to a network.
  */
-
-
- 
-
-
- //http_session_t * test_handle;
 static void start_services()
 {
 	dbg("Start Cloud");
 	//wm_demo_cloud_start();
-	
-	//----------------------------------	
-	int timeout = 5000;	//  ms
-	int status = http_open_session(&c.hS, "192.168.0.19:8089", 0,NULL,0);
-	cl_dbg("http_open_session status: %d",status);
-
-	/* Set timeout on cloud socket	*/
-	//http_setsockopt(&c.hS, 0xfff, 0x1006,
-	//	&timeout, sizeof(int));
-
-	//char buff[900];
-	//
-	//	 http_lowlevel_read(c.hS,buff,sizeof(buff));
-	//	 dbg("recv : %s",buff);
-		 
-//	os_thread_create(&app_thread_http_listen, /* thread handle */
-//				"http_listen", /* thread name */
-//				http_listen,	/* entry function */
-//				0,	/* argument */
-//				&app_stack_http_listen,	/* stack */
-//				OS_PRIO_2); /* priority - medium low */
 
+	/* Resumes the device channel session if it survived a link loss,
+	 * else the receiving thread opens a new one.
+	 */
+	wm_demo_chan_link_up();
 }
 /*
  * Event: INIT_DONE
@@ -390,20 +338,10 @@ static void event_init_done(void *data)
 #endif /* APPCONFIG_DEBUG_ENABLE */
 
 	dbg("Event: INIT_DONE");
+	wm_demo_boot_mark("init-done");
 	dbg("Factory reset bit status: %d", state->factory_reset);
 	dbg("Booting from backup firmware status: %d", state->backup_fw);
 	dbg("Previous reboot cause: %u", state->rst_cause);
-
-	int err = os_timer_create(&uap_down_timer,
-				  "uap-down-timer",
-				  os_msec_to_ticks(UAP_DOWN_TIMEOUT),
-				  &uap_down_timer_cb,
-				  NULL,
-				  OS_TIMER_ONE_SHOT,
-				  OS_TIMER_NO_ACTIVATE);
-	if (err != WM_SUCCESS) {
-		dbg("Unable to start uap down timer");
-	}
 }
 
 /*
@@ -441,12 +379,16 @@ static void event_wlan_init_done(void *data)
 	provisioned = (int)data;
 
 	dbg("Event: WLAN_INIT_DONE provisioned=%d", provisioned);
+	wm_demo_boot_mark("wlan-init");
+
+	/* The device key is only taken while provisioning */
+	wm_demo_lan_open_key(!provisioned);
 
 	/* Initialize ssid to be used for uAP mode */
 	appln_init_ssid();
 
 	if (provisioned) {
-		app_sta_start();
+		hp_fast_reconnect_sta_start();
 		/* Load  CLOUD overlay in memory */
 		wm_demo_load_cloud_overlay();
 	} else {
@@ -498,6 +440,15 @@ static void event_wlan_init_done(void *data)
 	 */
 	register_httpd_handlers();
 
+	/* Serve the gzip compressed JavaScript and CSS files */
+	wm_demo_assets_init(fs);
+
+	wm_demo_boot_mark("httpd");
+
+#ifndef APPCONFIG_DEFER_LOCAL
+	start_local_servers();
+#endif /* APPCONFIG_DEFER_LOCAL */
+
 	/*
 	 * Initialize CLI Commands for some of the modules:
 	 *
@@ -505,7 +456,6 @@ static void event_wlan_init_done(void *data)
 	 * -- ftfs: allows user to see contents of ftfs
 	 * -- wlan: allows user to explore basic wlan functions
 	 */
-
 	ret = psm_cli_init();
 	if (ret != WM_SUCCESS)
 		dbg("Error: psm_cli_init failed");
@@ -518,6 +468,7 @@ static void event_wlan_init_done(void *data)
 	ret = wlan_cli_init();
 	if (ret != WM_SUCCESS)
 		dbg("Error: wlan_cli_init failed");
+	wm_demo_boot_mark("cli-suites");
 
 	if (!provisioned) {
 		/* Start Slow Blink */
@@ -544,7 +495,12 @@ if(PROV_EZCONNECT)
 	void *iface_handle = net_get_uap_handle();
 
 	dbg("Event: Micro-AP Started");
+	wm_demo_lan_open_key(true);
 	if (!provisioned) {
+		/* Provisioning needs the scan cache now */
+		start_local_servers();
+		wm_demo_events_conn("provisioning");
+		wm_demo_scan_start();
 		dbg("Starting provisioning");
 #if APPCONFIG_WPS_ENABLE
 		hp_configure_wps_pushbutton();
@@ -572,6 +528,7 @@ if(PROV_EZCONNECT)
  */
 static void event_prov_done(void *data)
 {
+	wm_demo_scan_stop();
 	hp_configure_reset_prov_pushbutton();
 if(PROV_EZCONNECT)
 {
@@ -585,6 +542,8 @@ if(PROV_EZCONNECT)
  /* APPCONFIG_PROV_EZCONNECT */
 	dbg("Provisioning successful");
 }
+	/* The client may still post the device key over the Micro-AP */
+	wm_demo_lan_open_key(is_uap_started());
 }
 
 /* Event: PROV_CLIENT_DONE
@@ -621,6 +580,8 @@ static void event_prov_client_done(void *data)
 static void event_uap_stopped(void *data)
 {
 	dbg("Event: Micro-AP Stopped");
+	wm_demo_lan_open_key(!provisioned);
+	wm_demo_scan_stop();
 	hp_pm_wifi_ps_enable();
 }
 
@@ -654,7 +615,7 @@ static void event_prov_wps_ssid_select_req(void *data)
  * Restart the HTTP server that was stopped when WPS session attempt
  * began.
  */
-static void event_prov_wps_successful(void *data)
+static void wps_httpd_restart(void *arg)
 {
 	int ret;
 
@@ -662,7 +623,11 @@ static void event_prov_wps_successful(void *data)
 	if (ret != WM_SUCCESS) {
 		dbg("Error starting HTTP server");
 	}
+}
 
+static void event_prov_wps_successful(void *data)
+{
+	wm_demo_wq_post(WQ_PRIO_HIGH, wps_httpd_restart, NULL);
 	return;
 }
 
@@ -676,12 +641,7 @@ static void event_prov_wps_successful(void *data)
  */
 static void event_prov_wps_unsuccessful(void *data)
 {
-	int ret;
-
-	ret = app_httpd_with_fs_start(ftfs_api_version, ftfs_part_name, &fs);
-	if (ret != WM_SUCCESS) {
-		dbg("Error starting HTTP server");
-	}
+	wm_demo_wq_post(WQ_PRIO_HIGH, wps_httpd_restart, NULL);
 	return;
 }
 
@@ -704,6 +664,8 @@ static void event_normal_connecting(void *data)
 {
 	net_dhcp_hostname_set(appln_cfg.hostname);
 	dbg("Connecting to Home Network");
+	wm_demo_boot_mark("connecting");
+	wm_demo_events_conn("connecting");
 	/* Start Fast Blink */
 	led_fast_blink(board_led_2());
 }
@@ -721,36 +683,54 @@ static void event_normal_connected(void *data)
 	void *iface_handle;
 	char ip[16];
 
+	led_pattern_stop(board_led_2(), LED_PRIO_ERROR);
 	led_off(board_led_2());
 
 	led_on(board_led_1());
 
 	app_network_ip_get(ip);
 	dbg("Connected to Home Network with IP address = %s", ip);
+	wm_demo_boot_mark(BOOT_CONNECTED);
+	wm_demo_events_conn("connected");
+	hp_fast_reconnect_connected();
+	wm_demo_netsched_link_up();
 
 	iface_handle = net_get_sta_handle();
 	if (!mdns_announced) {
 		hp_mdns_announce(iface_handle, UP);
 		mdns_announced = 1;
 	} else {
-		hp_mdns_down_up(iface_handle);
+		/* New address: refresh the records without a DOWN/UP cycle */
+		hp_mdns_announce(iface_handle, REANNOUNCE);
 	}
 	/* Load CLOUD overlay in memory */
 	wm_demo_load_cloud_overlay();
 	start_services();
+	start_local_servers();
 	/*
 	 * If micro AP interface is up
 	 * queue a timer which will take
 	 * micro AP interface down.
 	 */
 	if (is_uap_started()) {
-		os_timer_activate(&uap_down_timer);
+		wm_demo_netsched_start(&uap_down_job, UAP_DOWN_TIMEOUT);
 		return;
 	}
 
 	//hp_pm_wifi_ps_enable();
 }
 
+/* Connection failure: double flashes, three times */
+static const struct led_step conn_failed_steps[] = {
+	{100, LED_LEVEL_MAX}, {100, 0}, {100, LED_LEVEL_MAX}, {700, 0},
+};
+
+static const struct led_pattern conn_failed_pattern = {
+	conn_failed_steps,
+	sizeof(conn_failed_steps) / sizeof(conn_failed_steps[0]),
+	3,
+};
+
 /*
  * Event: CONNECT_FAILED
  *
@@ -764,6 +744,27 @@ static void event_normal_connected(void *data)
  * -- We did not get a valid IP address from the AP
  *
  */
+/* The framework retries as soon as the failure is handled: stop the
+ * station and start it again after CONN_RETRY_MS instead.
+ */
+static bool conn_backing_off;
+static struct wq_delayed conn_retry_work;
+
+static void conn_backoff(void *arg)
+{
+	conn_backing_off = true;
+	app_sta_stop();
+	wm_demo_wq_post_delayed(&conn_retry_work, CONN_RETRY_MS);
+}
+
+static void conn_retry(void *arg)
+{
+	if (!conn_backing_off)
+		return;
+	conn_backing_off = false;
+	hp_fast_reconnect_sta_start();
+}
+
 static void event_connect_failed(void *data)
 {
 	char failure_reason[32];
@@ -775,9 +776,14 @@ static void event_connect_failed(void *data)
 	if (*(app_conn_failure_reason_t *)data == DHCP_FAILED)
 		strcpy(failure_reason, "DHCP failure");
 
-	os_thread_sleep(os_msec_to_ticks(2000));
 	dbg("Application Error: Connection Failed: %s", failure_reason);
 	led_off(board_led_1());
+	/* Flash over the connecting blink, which resumes afterwards */
+	led_pattern_start(board_led_2(), &conn_failed_pattern, LED_PRIO_ERROR);
+	wm_demo_events_conn("connect_failed");
+	/* A failed directed connect is retried at once with a full scan */
+	if (hp_fast_reconnect_failed() != WM_SUCCESS)
+		wm_demo_wq_post(WQ_PRIO_HIGH, conn_backoff, NULL);
 }
 
 /*
@@ -790,7 +796,12 @@ static void event_connect_failed(void *data)
 static void event_normal_user_disconnect(void *data)
 {
 	led_off(board_led_1());
+	if (conn_backing_off) {
+		dbg("Retrying connection in %d ms", CONN_RETRY_MS);
+		return;
+	}
 	dbg("User disconnect");
+	wm_demo_events_conn("disconnected");
 }
 
 /*
@@ -804,6 +815,9 @@ static void event_normal_user_disconnect(void *data)
 static void event_normal_link_lost(void *data)
 {
 	dbg("Link Lost");
+	wm_demo_events_conn("link_lost");
+	/* Keep the channel session, it is resumed on reconnection */
+	wm_demo_chan_link_down();
 }
 
 static void event_normal_pre_reset_prov(void *data)
@@ -815,6 +829,8 @@ static void event_normal_dhcp_renew(void *data)
 {
 	void *iface_handle = net_get_mlan_handle();
 	hp_mdns_announce(iface_handle, REANNOUNCE);
+	/* The session is reopened if our address changed */
+	wm_demo_chan_link_up();
 }
 
 static void event_normal_reset_prov(void *data)
@@ -825,16 +841,21 @@ static void event_normal_reset_prov(void *data)
 
 	/* Stop services like cloud */
 	stop_services();
+	wm_demo_events_conn("reset_to_prov");
 
 	/* Cancel the UAP down timer timer */
-	os_timer_deactivate(&uap_down_timer);
+	wm_demo_netsched_stop(&uap_down_job);
+	wm_demo_wq_cancel_delayed(&conn_retry_work);
+	conn_backing_off = false;
 
 	hp_pm_wifi_ps_disable();
 	/* Load WPS overlay in memory */
 	wm_demo_load_wps_overlay();
 
 	/* Reset to provisioning */
+	hp_fast_reconnect_invalidate();
 	provisioned = 0;
+	wm_demo_lan_open_key(true);
 	mdns_announced = 0;
 	hp_unconfigure_reset_prov_pushbutton();
 if(PROV_EZCONNECT)
@@ -901,6 +922,7 @@ static void event_ps_enter(void *data)
 		dbg("This will be fixed in subsequent "
 		    "software release.\r\n");
 	}
+	wm_demo_pm_wlan_state(ps_state);
 	ps_state_to_desc(ps_state_desc, ps_state);
 	dbg("Power save enter : %s", ps_state_desc);
 
@@ -917,6 +939,8 @@ static void event_ps_exit(void *data)
 {
 	int ps_state = (int) data;
 	char ps_state_desc[32];
+
+	wm_demo_pm_wlan_state(WLAN_ACTIVE);
 	ps_state_to_desc(ps_state_desc, ps_state);
 	dbg("Power save exit : %s", ps_state_desc);
 }
@@ -1000,12 +1024,16 @@ static void modules_init()
 		dbg("Error: wmstdio_init failed");
 		appln_critical_error_handler((void *) -WM_FAIL);
 	}
+	wm_demo_boot_mark("wmstdio");
 
 	ret = cli_init();
 	if (ret != WM_SUCCESS) {
 		dbg("Error: cli_init failed");
 		appln_critical_error_handler((void *) -WM_FAIL);
 	}
+	wm_demo_boot_cli_init();
+	wm_demo_boot_mark("cli");
+
 	/* Initialize time subsystem.
 	 *
 	 * Initializes time to 1/1/1970 epoch 0.
@@ -1015,6 +1043,7 @@ static void modules_init()
 		dbg("Error: wmtime_init failed");
 		appln_critical_error_handler((void *) -WM_FAIL);
 	}
+	wm_demo_boot_mark("wmtime");
 
 	/*
 	 * Register Time CLI Commands
@@ -1033,6 +1062,7 @@ static void modules_init()
 		dbg("Error: pm_init failed");
 		appln_critical_error_handler((void *) -WM_FAIL);
 	}
+	wm_demo_boot_mark("pm");
 
 	/*
 	 * Register Power Management CLI Commands
@@ -1054,7 +1084,11 @@ static void modules_init()
 		dbg("Error: gpio_drv_init failed");
 		appln_critical_error_handler((void *) -WM_FAIL);
 	}
+	wm_demo_boot_mark("gpio");
 
+	/* Before anything can hang: a device that does not connect is the one
+	 * to debug.
+	 */
 	ret = healthmon_init();
 	if (ret != WM_SUCCESS) {
 		dbg("Error: healthmon_init failed");
@@ -1068,6 +1102,7 @@ static void modules_init()
 	/* Set the final_about_to_die handler of the healthmon */
 	healthmon_set_final_about_to_die_handler
 		((void (*)())diagnostics_write_stats);
+	wm_demo_boot_mark("healthmon");
 
 	app_sys_register_diag_handler();
 	app_sys_register_upgrade_handler();
@@ -1092,23 +1127,35 @@ static unsigned int gpio_led_state;
 /* This function turns on the LED*/
 static void gpio_led_on(void)
 {
-	mdev_t *gpio_dev = gpio_drv_open("MDEV_GPIO");
 	/* Turn on LED by writing  0 in GPIO register */
-	gpio_drv_write(gpio_dev, gpio_led, 0);
-	gpio_drv_close(gpio_dev);
+	gpio_fast_pin(gpio_led, GPIO_IO_LOW);
 	gpio_led_state = 1;
 }
 
 /* This function turns off the LED*/
 static void gpio_led_off(void)
 {
-	mdev_t *gpio_dev = gpio_drv_open("MDEV_GPIO");
 	/* Turn off LED by writing  1 in GPIO register */
-	gpio_drv_write(gpio_dev, gpio_led, 1);
-	gpio_drv_close(gpio_dev);
+	gpio_fast_pin(gpio_led, GPIO_IO_HIGH);
 	gpio_led_state = 0;
 }
 
+/* Getter and setter of the "onOff" device property */
+int wm_demo_switch_get(struct prop_val *val)
+{
+	val->i = gpio_led_state;
+	return WM_SUCCESS;
+}
+
+int wm_demo_switch_set(const struct prop_val *val)
+{
+	if (val->i)
+		gpio_led_on();
+	else
+		gpio_led_off();
+	return WM_SUCCESS;
+}
+
 /* This function is called when push button is pressed*/
 static void pushbutton_cb()
 {
@@ -1173,43 +1220,42 @@ static void configure_gpios()
 
 static void report2cloud()
 {
-	time_t time;
-	char deviceName[24];
-	uint8_t my_mac[6];	
-	struct json_str jstr;
-	char buff[512];
+	struct wm_demo_msg_report msg;
+	char buff[WM_DEMO_MSG_REPORT_BUFSZ];
+	int len;
+
+	/* Report only what changed since the last report */
+	memset(&msg, 0, sizeof(msg));
+	msg.d_mask = wm_demo_props_snapshot(wm_demo_props_dirty(PROP_CH_CLOUD),
+					    PROP_CH_CLOUD, msg.d);
+	if (!msg.d_mask)
+		return;
 
-	
-	wlan_get_mac_address(my_mac);
-	snprintf(deviceName, sizeof(deviceName),
-				 "ck00345678%02X%02X%02X%02X%02X%02X", my_mac[0], my_mac[1],my_mac[2], my_mac[3],my_mac[4], my_mac[5]);
-
-	json_str_init(&jstr,buff,sizeof(buff),0);
-	json_start_object(&jstr);
-	json_set_val_str(&jstr,"a","report");
-	json_push_object(&jstr, "d");
-	json_push_array_object(&jstr, "pl");
-
-	json_start_object(&jstr);
-	json_set_val_int(&jstr,"onOff",gpio_led_state);
-	json_set_val_int(&jstr,"pid",0);
-	json_close_object(&jstr);
-	json_pop_array_object(&jstr);
-	json_pop_object(&jstr);
-	json_set_val_str(&jstr,"id",deviceName);
-	time = wmtime_time_get_posix();
-	json_set_val_int(&jstr, "t", time);
-	json_close_object(&jstr);
-	strcat(buff,"\r\n");
-	http_lowlevel_write(c.hS,buff,strlen(buff));
+	msg.id = wm_demo_sn_id();
+	msg.has_id = true;
+	msg.t = wmtime_time_get_posix();
+	msg.has_t = true;
 
-	
+	len = wm_demo_msg_report_encode(&msg, &buff);
+	if (wm_demo_chan_send(buff, len) == WM_SUCCESS)
+		wm_demo_boot_mark(BOOT_FIRST_REPORT);
+	else /* Sent again when the channel is back */
+		wm_demo_props_mark_dirty(msg.d_mask, PROP_CH_CLOUD);
+}
 
+/* The device channel session was (re)opened or resumed. The server may
+ * have missed updates in between, send it the complete state.
+ */
+static void chan_up()
+{
+	wm_demo_props_mark_dirty(PROP_MASK_ALL, PROP_CH_CLOUD);
+	report2cloud();
 }
 
 static void button_click()
 {
-	int state;
+	static struct wake_point button_wp = {"button"};
+	int state, prev_state;
 	int cycle_cnt;
 	int low_cnt;
 	mdev_t  *gpio_dev = gpio_drv_open("MDEV_GPIO");	
@@ -1222,6 +1268,7 @@ static void button_click()
 	
 	while(1){
 		os_semaphore_get(&button_sem, OS_WAIT_FOREVER);
+		wake_audit(&button_wp, WAKE_ISR, true);
 		cycle_cnt = 0;
 		low_cnt =0;
 		gpio_drv_read(gpio_dev,gpio_pushbutton,&state);
@@ -1229,6 +1276,7 @@ static void button_click()
 		{
 			while(cycle_cnt<5)
 			{
+				prev_state = state;
 				gpio_drv_read(gpio_dev,gpio_pushbutton,&state);
 				if(state == GPIO_IO_HIGH)
 					cycle_cnt ++;
@@ -1254,6 +1302,9 @@ static void button_click()
 				}
 				
 				os_thread_sleep(os_msec_to_ticks(20));
+				/* Debouncing polls: the pin level changed or not */
+				wake_audit(&button_wp, WAKE_TIMEOUT,
+					   state != prev_state);
 			}
 			
 			
@@ -1267,10 +1318,10 @@ static void button_click()
 			
 			if(low_cnt < 5*5)
 			{
-				if (gpio_led_state)
-					gpio_led_off();
-				else
-					gpio_led_on();
+				int on = 0;
+
+				wm_demo_prop_get_int(PROP_ID_onOff, &on);
+				wm_demo_prop_set_int(PROP_ID_onOff, !on);
 
 				report2cloud();
 				
@@ -1305,66 +1356,87 @@ static void button_click()
 
 static void http_listen()
  {
-	 char buff[512];
-	 //char buff_array[128];
-	 struct json_object json_obj;
-	 struct json_object array_json_obj;
-	 int led_val;
-	 char status[5];
-	 time_t time;
-	 int array_val;
-	 json_object_init(&json_obj, buff);
+	 char buff[WM_DEMO_MSG_RX_BUFSZ];
+	 struct wm_demo_msg_cmd msg;
+	 unsigned mask;
+	 int len;
+	 static struct wake_point wp = {"http_listen"};
+
 	 while(1)
 	 {
-		if(c.hS)
+		/* Waits for the channel when it is down */
+		len = wm_demo_chan_recv(buff, sizeof(buff) - 1);
+		wake_audit(&wp, len > 0 ? WAKE_MSG : WAKE_TIMEOUT, len > 0);
+		if(len > 0)
 		{
-			memset(buff,0,sizeof(buff));
-			if(http_lowlevel_read(c.hS,buff,sizeof(buff))>0)
-			{
-				dbg("recv : %s",buff);
-				
-				
-				if(json_get_val_int(&json_obj, "t", (int *)&time) == WM_SUCCESS)
-				{
-					wmtime_time_set_posix(time);
-					dbg("time : %d",time);
-				}
-				
-				json_get_array_object(&json_obj, "pl");	
-				if(json_obj.array_obj>0)
-				{
-					json_object_init(&array_json_obj, (char *)(buff + json_obj.array_obj +1));
-					dbg("array : %d,curr : %d",json_obj.array_obj,json_obj.current_obj);
-					
-					if(json_get_val_int(&array_json_obj, "onOff", &led_val) == WM_SUCCESS)
-					{
-						if (led_val)
-							gpio_led_on();
-						else
-							gpio_led_off();
-					}
+			buff[len] = 0;
+			dbg("recv : %s",buff);
+
+			//{"data":true,"status":"ok","t":1426857651}
+			//{"code":"PARAMS_ILLEGAL_OR_DATA_ILLEGAL","status":"error"}
+			if (wm_demo_msg_cmd_decode(buff, len, &msg)
+			    == WM_SUCCESS) {
+				if (msg.has_t) {
+					wmtime_time_set_posix(msg.t);
+					dbg("time : %d", msg.t);
 				}
 
-				
-				//{"data":true,"status":"ok","t":1426857651}
-				//{"code":"PARAMS_ILLEGAL_OR_DATA_ILLEGAL","status":"error"}
-				json_get_val_str(&json_obj, "status",status,sizeof(status));
-				dbg("recv : %d,%s",led_val,status);				
+				mask = wm_demo_msg_apply_props(msg.d_mask,
+							       msg.d) |
+					msg.d_query;
+				dbg("recv : %x,%s", mask,
+				    msg.has_status ? msg.status : "");
+			} else {
+				dbg("Error: malformed message");
 			}
 		}
-		 os_thread_sleep(os_msec_to_ticks(1000));
 	 }
  }
 
 
 int main()
 {
+	wm_demo_boot_mark(BOOT_MAIN);
 	modules_init();
 
 	dbg("Build Time: " __DATE__ " " __TIME__ "");
 
 	appln_config_init();
 
+	if (led_indicator_init() != WM_SUCCESS)
+		dbg("Error: LED timer creation failed");
+
+	wm_demo_props_init();
+
+	if (wm_demo_wq_init(APPCONFIG_WQ_WORKERS) != WM_SUCCESS) {
+		dbg("Error: work queue init failed");
+		appln_critical_error_handler((void *) -WM_FAIL);
+	}
+	wm_demo_wq_cli_init();
+	if (wm_demo_wq_delayed_init(&conn_retry_work, WQ_PRIO_HIGH, conn_retry,
+				    NULL) != WM_SUCCESS)
+		dbg("Error: connection retry timer creation failed");
+
+	if (wm_demo_netsched_init() != WM_SUCCESS)
+		dbg("Error: network scheduler init failed");
+	wm_demo_netsched_cli_init();
+
+	if (wm_demo_chan_init(WM_DEMO_CHAN_URL, chan_up) != WM_SUCCESS) {
+		dbg("Error: device channel init failed");
+		appln_critical_error_handler((void *) -WM_FAIL);
+	}
+	wm_demo_chan_cli_init();
+	wm_demo_assets_cli_init();
+	wm_demo_events_cli_init();
+	wm_demo_scan_cli_init();
+	wm_demo_lan_cli_init();
+	http_admit_cli_init();
+	wm_demo_pm_cli_init();
+	wake_audit_cli_init();
+	hp_pm_cli_init();
+	hp_mdns_cli_init();
+	wm_demo_boot_mark("app-init");
+
 	int status = os_semaphore_create(&button_sem, "button");
 	
 	if (status != WM_SUCCESS) {
@@ -3,11 +3,18 @@
  *  All Rights Reserved.
  */
 #include <wmstdio.h>
+#include <string.h>
 #include <app_framework.h>
+#include <cli.h>
 #include <mdns_helper.h>
 #include <appln_cb.h>
 #include <appln_dbg.h>
 #include <wm_utils.h>
+#include <wm_demo_lan.h>
+#include <wm_demo_netsched.h>
+#include <wm_demo_props.h>
+#include <wm_demo_msg.h>
+#include <wm_demo_wq.h>
 
 struct mdns_service my_service = {
 	.servname = appln_cfg.servname,
@@ -18,41 +25,273 @@ struct mdns_service my_service = {
 };
 
 #define MAX_MDNS_TXT_SIZE 128
-char mytxt[MAX_MDNS_TXT_SIZE];
+
+/* Key/value pairs of the TXT record. The record is only rebuilt when one
+ * of them actually changes, into the buffer the responder is not using.
+ */
+struct mdns_txt {
+	const char *key;
+	char val[MDNS_TXT_VAL_LEN];
+};
+
+/* An interface the service is announced on. Changes of the record are
+ * re-announced with one unsolicited response, at most every
+ * MDNS_REANNOUNCE_MS; changes in between go out together.
+ */
+struct mdns_iface {
+	void *iface;			/* NULL if unused */
+	unsigned long last;		/* ticks, last announcement */
+	struct netsched_job job;
+};
+
+static struct {
+	struct mdns_txt txt[MDNS_TXT_KEYS];
+	int ntxt;
+	char buf[2][MAX_MDNS_TXT_SIZE];
+	int cur;			/* buffer in use by the responder */
+	bool dirty;			/* record to rebuild */
+	struct mdns_iface ifs[MDNS_IFACES];
+	volatile bool state_queued;	/* mdns_txt_state() posted */
+	unsigned updates, unchanged, reannounces;
+} md;
+
+static os_mutex_t mdns_mutex;
+
+/* Called with mdns_mutex held */
+static void mdns_txt_build(void)
+{
+	char *b = md.buf[!md.cur];
+	int i, len = 0;
+
+	if (!md.dirty)
+		return;
+	b[0] = 0;
+	for (i = 0; i < md.ntxt && len < MAX_MDNS_TXT_SIZE; i++)
+		len += snprintf(b + len, MAX_MDNS_TXT_SIZE - len, "%s%s=%s",
+				i ? ":" : "", md.txt[i].key, md.txt[i].val);
+	if (len >= MAX_MDNS_TXT_SIZE)
+		dbg("mdns: TXT record truncated");
+	SET_TXT_REC(my_service, b);
+	md.cur = !md.cur;
+	md.dirty = false;
+}
+
+static struct mdns_iface *mdns_iface_find(void *iface)
+{
+	int i;
+
+	for (i = 0; i < MDNS_IFACES; i++)
+		if (md.ifs[i].iface == iface)
+			return &md.ifs[i];
+	return NULL;
+}
+
+static void mdns_reannounce_work(void *arg)
+{
+	struct mdns_iface *ifc = arg;
+	void *iface;
+
+	os_mutex_get(&mdns_mutex, OS_WAIT_FOREVER);
+	iface = ifc->iface;
+	mdns_txt_build();
+	ifc->last = os_ticks_get();
+	md.reannounces++;
+	os_mutex_put(&mdns_mutex);
+
+	if (iface)
+		app_mdns_iface_state_change(iface, REANNOUNCE);
+}
+
+/* Called with mdns_mutex held */
+static void mdns_reannounce(struct mdns_iface *ifc)
+{
+	long wait;
+
+	if (ifc->job.active)
+		return;
+	wait = os_ticks_to_msec(ifc->last + os_msec_to_ticks(
+					MDNS_REANNOUNCE_MS) - os_ticks_get());
+	wm_demo_netsched_start(&ifc->job, wait > 0 ? wait : 0);
+}
+
+int hp_mdns_txt_set(const char *key, const char *val)
+{
+	struct mdns_txt *t = NULL;
+	bool added = false;
+	int i;
+
+	os_mutex_get(&mdns_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < md.ntxt; i++)
+		if (!strcmp(md.txt[i].key, key))
+			t = &md.txt[i];
+	if (!t) {
+		if (md.ntxt == MDNS_TXT_KEYS) {
+			os_mutex_put(&mdns_mutex);
+			return -WM_E_NOMEM;
+		}
+		t = &md.txt[md.ntxt++];
+		t->key = key;
+		added = true;
+	}
+
+	if (!added && !strncmp(t->val, val, sizeof(t->val) - 1)) {
+		md.unchanged++;
+		os_mutex_put(&mdns_mutex);
+		return WM_SUCCESS;
+	}
+	snprintf(t->val, sizeof(t->val), "%s", val);
+	md.dirty = true;
+	md.updates++;
+	for (i = 0; i < MDNS_IFACES; i++)
+		if (md.ifs[i].iface)
+			mdns_reannounce(&md.ifs[i]);
+	os_mutex_put(&mdns_mutex);
+	return WM_SUCCESS;
+}
+
+/* Device state in the record: "sw" is the onOff property and "gen" the
+ * state generation, which changes with it. Run on the work queue.
+ */
+static void mdns_txt_state(void *arg)
+{
+	struct prop_val vals[PROP_COUNT];
+	unsigned mask;
+	char val[12];
+
+	md.state_queued = false;
+	mask = wm_demo_props_snapshot(wm_demo_props_dirty(PROP_CH_MDNS),
+				      PROP_CH_MDNS, vals);
+	if (mask & PROP_MASK(PROP_ID_onOff))
+		hp_mdns_txt_set("sw", vals[PROP_ID_onOff].i ? "1" : "0");
+	snprintf(val, sizeof(val), "%u", wm_demo_props_gen());
+	hp_mdns_txt_set("gen", val);
+}
+
+/* Property change callback: may run in any thread, must not block */
+static void mdns_props_changed(void)
+{
+	unsigned long flags = os_enter_critical_section();
+	bool queued = md.state_queued;
+
+	md.state_queued = true;
+	os_exit_critical_section(flags);
+	if (!queued && wm_demo_wq_post(WQ_PRIO_LOW, mdns_txt_state, NULL)
+	    != WM_SUCCESS)
+		md.state_queued = false;
+}
+
+int hp_mdns_init(void)
+{
+	char val[12];
+	int i, ret;
+
+	if (mdns_mutex)
+		return WM_SUCCESS;
+
+	ret = os_mutex_create(&mdns_mutex, "mdns-txt", OS_MUTEX_INHERIT);
+	if (ret != WM_SUCCESS)
+		return ret;
+
+	for (i = 0; i < MDNS_IFACES; i++) {
+		md.ifs[i].job.name = "mdns";
+		md.ifs[i].job.fn = mdns_reannounce_work;
+		md.ifs[i].job.arg = &md.ifs[i];
+		md.ifs[i].job.slack_ms = MDNS_REANNOUNCE_SLACK_MS;
+	}
+
+	/* system epoch changes after every reboot. Adding epoch in mdns
+	 * txt record will update txt record after every reboot and
+	 * hence mdns querier will give MDNS_UPDATE event.
+	 */
+	hp_mdns_txt_set("txtvers", MDNS_TXT_VERSION);
+	snprintf(val, sizeof(val), "%d", sys_get_epoch());
+	hp_mdns_txt_set("epoch", val);
+	snprintf(val, sizeof(val), "%d", LAN_PORT);
+	hp_mdns_txt_set("lan", val);
+	hp_mdns_txt_set("fw", APPCONFIG_FW_VERSION);
+	mdns_txt_state(NULL);
+	if (wm_demo_props_add_notify(mdns_props_changed) != WM_SUCCESS)
+		dbg("mdns: no room for the property change callback");
+	return WM_SUCCESS;
+}
 
 void hp_mdns_announce(void *iface, int state)
 {
+	struct mdns_iface *ifc;
+
+	if (hp_mdns_init() != WM_SUCCESS)
+		return;
+
+	/* The serial number comes from the MAC address, known by now */
+	if (state == UP && *wm_demo_sn_id())
+		hp_mdns_txt_set("snId", wm_demo_sn_id());
+
+	os_mutex_get(&mdns_mutex, OS_WAIT_FOREVER);
+	ifc = mdns_iface_find(iface);
+	if (state == REANNOUNCE) {
+		/* Not announced there yet: nothing to refresh */
+		if (ifc)
+			mdns_reannounce(ifc);
+		os_mutex_put(&mdns_mutex);
+		return;
+	}
 	if (state == UP) {
-		/* system epoch changes after every reboot. Adding epoch in mdns
-		 * txt record will update txt record after every reboot and
-		 * hence mdns querier will give MDNS_UPDATE event.
-		 */
-		snprintf(mytxt, MAX_MDNS_TXT_SIZE, "txtvers=2:epoch=%d",
-			 sys_get_epoch());
-		SET_TXT_REC(my_service, mytxt);
+		if (!ifc)
+			ifc = mdns_iface_find(NULL);
+		if (ifc) {
+			ifc->iface = iface;
+			ifc->last = os_ticks_get();
+		}
+		mdns_txt_build();
+	}
+	os_mutex_put(&mdns_mutex);
+
+	if (state == UP)
 		app_mdns_add_service(&my_service, iface);
-	} else {
+	else
 		app_mdns_iface_state_change(iface, state);
-	}
 }
 
 void hp_mdns_deannounce(void *iface)
 {
+	struct mdns_iface *ifc;
+
+	if (mdns_mutex) {
+		os_mutex_get(&mdns_mutex, OS_WAIT_FOREVER);
+		ifc = mdns_iface_find(iface);
+		if (ifc) {
+			wm_demo_netsched_stop(&ifc->job);
+			ifc->iface = NULL;
+		}
+		os_mutex_put(&mdns_mutex);
+	}
 	app_mdns_remove_service(&my_service, iface);
 }
 
-void hp_mdns_down_up(void *iface)
+static void mdns_txt_cmd(int argc, char **argv)
 {
-	/* mdns interface state is changed to DOWN to
-	 * to remove previous mdns service from
-	 * mdns querier cache. Later state is changed
-	 * to UP to add services in querier cache.
-	 */
-	app_mdns_iface_state_change(iface, DOWN);
-	/* 100ms sleep is added to send mdns down packet before
-	 * announcing service again.
-	 */
-	os_thread_sleep(os_msec_to_ticks(100));
-	hp_mdns_announce(iface, UP);
+	int i;
+
+	os_mutex_get(&mdns_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < md.ntxt; i++)
+		wmprintf("%s=%s\r\n", md.txt[i].key, md.txt[i].val);
+	wmprintf("updates %u unchanged %u reannounces %u\r\n", md.updates,
+		 md.unchanged, md.reannounces);
+	os_mutex_put(&mdns_mutex);
+}
+
+static struct cli_command mdns_cmds[] = {
+	{"mdns-txt", NULL, mdns_txt_cmd},
+};
+
+int hp_mdns_cli_init(void)
+{
+	int i;
 
+	if (hp_mdns_init() != WM_SUCCESS)
+		return -WM_FAIL;
+	for (i = 0; i < sizeof(mdns_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&mdns_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
 }
@@ -6,17 +6,69 @@
 #ifndef MDNS_HELPER_H_
 #define MDNS_HELPER_H_
 
+/* TXT record of the service, version MDNS_TXT_VERSION:
+ *
+ *	txtvers	MDNS_TXT_VERSION
+ *	epoch	boot time, changes on every boot
+ *	lan	UDP port of the LAN control protocol
+ *	snId	device serial number
+ *	fw	APPCONFIG_FW_VERSION
+ *	sw	switch state, 0 or 1
+ *	gen	state generation, bumped on every state change (and reset by
+ *		a reboot, see epoch)
+ *
+ * so that a controller learns the devices and their state from a browse,
+ * without a GET of /hello on each one.
+ */
+#define MDNS_TXT_VERSION		"3"
+#ifndef APPCONFIG_FW_VERSION
+#define APPCONFIG_FW_VERSION		"1.0.0"
+#endif
+
+#define MDNS_TXT_KEYS			8
+#define MDNS_TXT_VAL_LEN		24
+#define MDNS_IFACES			2
+/* Re-announcements, per interface: at most one every MDNS_REANNOUNCE_MS,
+ * possibly MDNS_REANNOUNCE_SLACK_MS early along with other traffic.
+ */
+#define MDNS_REANNOUNCE_MS		5000
+#define MDNS_REANNOUNCE_SLACK_MS	1000
+
 /* mDNS */
 #ifdef APPCONFIG_MDNS_ENABLE
+int hp_mdns_init(void);
+/** UP announces the service, REANNOUNCE refreshes it without a down/up
+ * cycle (rate limited, never blocks), DOWN is passed on.
+ */
 void hp_mdns_announce(void *iface, int state);
 void hp_mdns_deannounce(void *iface);
-void hp_mdns_down_up(void *iface);
+/** Set key to val in the TXT record. key must be a string literal. Does
+ * nothing if the value is the same, re-announces the record otherwise.
+ */
+int hp_mdns_txt_set(const char *key, const char *val);
+/** Register the "mdns-txt" CLI command */
+int hp_mdns_cli_init(void);
 #else
-static inline void hp_mdns_down_up(void *iface)
-{}
+static inline int hp_mdns_init(void)
+{
+	return WM_SUCCESS;
+}
 
 static inline void hp_mdns_announce(void *iface, int state)
 {}
+
+static inline void hp_mdns_deannounce(void *iface)
+{}
+
+static inline int hp_mdns_txt_set(const char *key, const char *val)
+{
+	return WM_SUCCESS;
+}
+
+static inline int hp_mdns_cli_init(void)
+{
+	return WM_SUCCESS;
+}
 #endif   /* APPCONFIG_MDNS_ENABLE */
 
 #endif /* ! _HELPERS_H_ */
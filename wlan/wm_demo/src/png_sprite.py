@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# Copyright (C) 2008-2015, Marvell International Ltd.
+# All Rights Reserved.
+#
+# Merge PNG images side by side into one sprite
+#
+# Usage: png_sprite.py <out.png> <in.png>...
+#
+# The images must be 8-bit RGBA, non-interlaced and of the same height.
+# Image n is at x offset (sum of the widths of images 0..n-1) in the
+# sprite. Only the standard library is used so that no image tools are
+# needed on the build host.
+
+import struct
+import sys
+import zlib
+
+PNG_SIG = b'\x89PNG\r\n\x1a\n'
+BPP = 4
+
+
+def chunks(data):
+    pos = len(PNG_SIG)
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        yield kind, data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(raw, width, height):
+    stride = width * BPP
+    rows = []
+    prev = bytearray(stride)
+    pos = 0
+    for _ in range(height):
+        ftype = raw[pos]
+        row = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = row[i - BPP] if i >= BPP else 0
+            b = prev[i]
+            c = prev[i - BPP] if i >= BPP else 0
+            if ftype == 1:
+                row[i] = (row[i] + a) & 0xff
+            elif ftype == 2:
+                row[i] = (row[i] + b) & 0xff
+            elif ftype == 3:
+                row[i] = (row[i] + ((a + b) >> 1)) & 0xff
+            elif ftype == 4:
+                row[i] = (row[i] + paeth(a, b, c)) & 0xff
+        rows.append(row)
+        prev = row
+    return rows
+
+
+def read_png(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not data.startswith(PNG_SIG):
+        sys.exit('%s: not a PNG file' % path)
+    idat = b''
+    for kind, body in chunks(data):
+        if kind == b'IHDR':
+            w, h, depth, ctype, _, _, interlace = \
+                struct.unpack('>IIBBBBB', body)
+            if depth != 8 or ctype != 6 or interlace:
+                sys.exit('%s: not 8-bit RGBA non-interlaced' % path)
+        elif kind == b'IDAT':
+            idat += body
+    return w, h, unfilter(zlib.decompress(idat), w, h)
+
+
+def chunk(kind, body):
+    crc = zlib.crc32(kind + body) & 0xffffffff
+    return struct.pack('>I', len(body)) + kind + body + struct.pack('>I', crc)
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('Usage: %s <out.png> <in.png>...' % sys.argv[0])
+
+    images = [read_png(p) for p in sys.argv[2:]]
+    height = images[0][1]
+    if any(h != height for _, h, _ in images):
+        sys.exit('images must have the same height')
+    width = sum(w for w, _, _ in images)
+
+    raw = b''.join(b'\0' + b''.join(bytes(rows[y]) for _, _, rows in images)
+                   for y in range(height))
+    ihdr = struct.pack('>IIBBBBB', width, height, 8, 6, 0, 0, 0)
+    with open(sys.argv[1], 'wb') as f:
+        f.write(PNG_SIG + chunk(b'IHDR', ihdr) +
+                chunk(b'IDAT', zlib.compress(raw, 9)) + chunk(b'IEND', b''))
+
+
+if __name__ == '__main__':
+    main()
@@ -6,19 +6,81 @@
 /* System includes */
 #include <wmstdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <wmtime.h>
 #include <wm_os.h>
 #include <wlan.h>
 #include <pwrmgr.h>
 #include <appln_dbg.h>
 #include <app_framework.h>
+#include <cli.h>
+#include <led_indicator.h>
+#include <wm_demo_wq.h>
 #include "power_mgr_helper.h"
 
 /* When CPU is expected to be idle for more than this time (millisecond) in
- * future, low power state is entered.
+ * future, low power state is entered. This is where the adaptive threshold
+ * starts.
  */
 #define THRESHOLD_TIME 10
 
+/* Adaptive PM2 threshold
+ *
+ * Whether PM2 pays depends on how long the CPU actually stays there: the
+ * entry and exit cost a fixed amount of charge (saving and restoring the
+ * state, the clocks coming back), and an early wakeup by an interrupt ends
+ * the stay before the current saved makes up for it. Every stay is put in
+ * a histogram and weighed against that cost. Every HP_PM_WINDOW_MS the
+ * net saving of the window decides the threshold for the next one. A
+ * window is closed by the first PM2 exit past its end, the CPU being
+ * awake then anyway, so adapting never wakes it. Only a window with no
+ * stay at all (PM2 off, or no idle long enough) is closed by a timer, the
+ * CPU not being in PM2 then:
+ *
+ *  - a loss: idles predicted this long are too often cut short, move up
+ *    one threshold. Past the last one, PM2 is turned off and tried again
+ *    at the highest threshold after HP_PM_OFF_WINDOWS windows.
+ *  - a gain with few stays under the break-even time, or no stay at all:
+ *    move down one threshold to catch the shorter idles as well.
+ */
+#define HP_PM_WINDOW_MS		10000
+#define HP_PM_OFF_WINDOWS	6
+#define HP_PM_BUCKETS		11	/* 0, 1, 2-3, ..., 512 ms and more */
+
+/* Current model, in microamperes: CPU idle outside PM2 (WFI), in PM2, and
+ * the charge of one PM2 entry and exit in microampere-milliseconds.
+ */
+#define HP_PM_IDLE_UA		8000
+#define HP_PM_PM2_UA		60
+#define HP_PM_SWITCH_UAMS	30000
+
+static const int hp_pm_thresholds[] = {2, 5, 10, 20, 50, 100, 200};
+#define HP_PM_NTHRESHOLDS \
+	(sizeof(hp_pm_thresholds) / sizeof(hp_pm_thresholds[0]))
+
+static struct {
+	bool fixed;			/* adaptation off */
+	int level;			/* in hp_pm_thresholds, -1 for PM2 off */
+	int off_windows;
+	unsigned long entered;		/* ticks */
+	unsigned long w_start;		/* ticks */
+	volatile bool queued;		/* hp_pm_adapt() posted */
+	/* Window being filled, from the PM callbacks */
+	unsigned w_stays, w_short;
+	int64_t w_gain;			/* uAms */
+	/* Totals */
+	unsigned hist[HP_PM_BUCKETS];
+	unsigned windows, up, down, off, probe;
+	int64_t last_gain;
+	int idle_ua, pm2_ua, switch_uams;
+} adapt = {
+	.idle_ua = HP_PM_IDLE_UA,
+	.pm2_ua = HP_PM_PM2_UA,
+	.switch_uams = HP_PM_SWITCH_UAMS,
+};
+
+/* Closes windows without PM2 stays */
+static struct wq_delayed adapt_work;
 
 static unsigned int pm_cb_handle;
 
@@ -41,6 +103,7 @@ static void hp_pm_cb(power_save_event_t event, void *data)
 		wake_status = true;
 		pm_mc200_cfg(false, PM1, 0);
 		pm_ieeeps_hs_cfg(false, 0);
+		led_sw_pwm_allow(true);
 	}
 }
 
@@ -52,6 +115,8 @@ bool hp_pm_get_wake_status(void)
 void hp_pm_reset_wake_status()
 {
 	wake_status = false;
+	/* Adapt again from a fresh window */
+	wm_demo_wq_post_delayed(&adapt_work, HP_PM_WINDOW_MS);
 }
 
 void hp_pm_set_wake_status()
@@ -60,6 +125,122 @@ void hp_pm_set_wake_status()
 }
 
 
+static int hp_pm_bucket(unsigned long ms)
+{
+	int b = 0;
+
+	while (ms && b < HP_PM_BUCKETS - 1) {
+		ms >>= 1;
+		b++;
+	}
+	return b;
+}
+
+/* Stays shorter than this lose charge */
+static int hp_pm_break_even_ms(void)
+{
+	int saved = adapt.idle_ua - adapt.pm2_ua;
+
+	return saved > 0 ? adapt.switch_uams / saved : -1;
+}
+
+static void hp_pm_adapt(void *arg);
+
+/* Called from the idle task around PM2 */
+static void hp_pm_adapt_cb(power_save_event_t event, void *data)
+{
+	unsigned long ms, flags;
+
+	if (event == ACTION_ENTER_PM2) {
+		adapt.entered = os_ticks_get();
+		return;
+	}
+
+	ms = os_ticks_to_msec(os_ticks_get() - adapt.entered);
+	flags = os_enter_critical_section();
+	adapt.hist[hp_pm_bucket(ms)]++;
+	adapt.w_stays++;
+	adapt.w_gain += (int64_t)(adapt.idle_ua - adapt.pm2_ua) * ms -
+		adapt.switch_uams;
+	if ((int)ms < hp_pm_break_even_ms())
+		adapt.w_short++;
+	os_exit_critical_section(flags);
+
+	if (!adapt.queued && os_ticks_to_msec(os_ticks_get() -
+					      adapt.w_start) >= HP_PM_WINDOW_MS) {
+		adapt.queued = true;
+		if (wm_demo_wq_post(WQ_PRIO_LOW, hp_pm_adapt, NULL) !=
+		    WM_SUCCESS)
+			adapt.queued = false;
+	}
+}
+
+/* Dimming LEDs in software would keep the core out of PM2 */
+static void hp_pm_apply(void)
+{
+	if (adapt.level < 0)
+		pm_mc200_cfg(false, PM1, 0);
+	else
+		pm_mc200_cfg(true, PM2, hp_pm_thresholds[adapt.level]);
+	led_sw_pwm_allow(adapt.level < 0);
+}
+
+/* Close the window, on the work queue */
+static void hp_pm_adapt(void *arg)
+{
+	unsigned stays, shorts;
+	unsigned long flags;
+	int level = adapt.level;
+	int64_t gain;
+
+	flags = os_enter_critical_section();
+	stays = adapt.w_stays;
+	shorts = adapt.w_short;
+	gain = adapt.w_gain;
+	adapt.w_stays = adapt.w_short = 0;
+	adapt.w_gain = 0;
+	adapt.w_start = os_ticks_get();
+	adapt.queued = false;
+	os_exit_critical_section(flags);
+
+	/* The wake key turned power management off, leave it so */
+	if (adapt.fixed || wake_status) {
+		wm_demo_wq_cancel_delayed(&adapt_work);
+		return;
+	}
+
+	adapt.windows++;
+	adapt.last_gain = gain;
+	if (level < 0) {
+		if (++adapt.off_windows < HP_PM_OFF_WINDOWS)
+			return;
+		level = HP_PM_NTHRESHOLDS - 1;
+		adapt.probe++;
+	} else if (stays && gain < 0) {
+		if (++level == HP_PM_NTHRESHOLDS) {
+			level = -1;
+			adapt.off_windows = 0;
+			adapt.off++;
+		} else {
+			adapt.up++;
+		}
+	} else if ((!stays || shorts * 8 < stays) && level > 0) {
+		level--;
+		adapt.down++;
+	}
+
+	if (level != adapt.level) {
+		adapt.level = level;
+		hp_pm_apply();
+	}
+
+	/* No PM2 exit is coming to close the next window */
+	if (!stays || level < 0)
+		wm_demo_wq_post_delayed(&adapt_work, HP_PM_WINDOW_MS);
+	else
+		wm_demo_wq_cancel_delayed(&adapt_work);
+}
+
 int hp_pm_init()
 {
 
@@ -72,11 +253,21 @@ int hp_pm_init()
 	 */
 	pm_mc200_io_cfg(false, true, false);
 
-	pm_mc200_cfg(true, PM2, THRESHOLD_TIME);
+	for (adapt.level = 0; adapt.level < HP_PM_NTHRESHOLDS - 1 &&
+		     hp_pm_thresholds[adapt.level] < THRESHOLD_TIME;
+	     adapt.level++)
+		;
+	hp_pm_apply();
 
 	pm_cb_handle = pm_register_cb(ACTION_EXIT_PM2 | ACTION_EXIT_PM3,
 			hp_pm_cb, NULL);
-	return WM_SUCCESS;
+	pm_register_cb(ACTION_ENTER_PM2 | ACTION_EXIT_PM2, hp_pm_adapt_cb,
+		       NULL);
+	adapt.w_start = os_ticks_get();
+	if (wm_demo_wq_delayed_init(&adapt_work, WQ_PRIO_LOW, hp_pm_adapt,
+				    NULL) != WM_SUCCESS)
+		return -WM_FAIL;
+	return wm_demo_wq_post_delayed(&adapt_work, HP_PM_WINDOW_MS);
 }
 
 void hp_pm_wifi_ps_enable()
@@ -100,3 +291,75 @@ void hp_pm_wifi_ps_disable()
 {
 	pm_ieeeps_hs_cfg(false, 0);
 }
+
+static void pm_adapt_cmd(int argc, char **argv)
+{
+	int i, from = 0;
+
+	if (argc == 2 && !strcmp(argv[1], "auto")) {
+		adapt.fixed = false;
+		wm_demo_wq_post_delayed(&adapt_work, HP_PM_WINDOW_MS);
+		return;
+	}
+	if (argc == 3 && !strcmp(argv[1], "fixed")) {
+		adapt.fixed = true;
+		adapt.level = -1;
+		for (i = 0; i < HP_PM_NTHRESHOLDS; i++)
+			if (hp_pm_thresholds[i] == atoi(argv[2]))
+				adapt.level = i;
+		/* The wake key turned power management off, leave it so */
+		if (wake_status) {
+			wmprintf("Power management is off (wake key), "
+				 "threshold not applied\r\n");
+			return;
+		}
+		hp_pm_apply();
+		return;
+	}
+	if (argc == 5 && !strcmp(argv[1], "model")) {
+		adapt.idle_ua = atoi(argv[2]);
+		adapt.pm2_ua = atoi(argv[3]);
+		adapt.switch_uams = atoi(argv[4]);
+		return;
+	}
+	if (argc != 1) {
+		wmprintf("Usage: %s [auto | fixed <ms> | model <idle uA> "
+			 "<pm2 uA> <switch uAms>]\r\n", argv[0]);
+		wmprintf("A fixed threshold other than");
+		for (i = 0; i < HP_PM_NTHRESHOLDS; i++)
+			wmprintf(" %d", hp_pm_thresholds[i]);
+		wmprintf(" ms turns PM2 off\r\n");
+		return;
+	}
+
+	if (adapt.level < 0)
+		wmprintf("PM2 off");
+	else
+		wmprintf("threshold %d ms", hp_pm_thresholds[adapt.level]);
+	wmprintf(" (%s), break-even %d ms\r\n",
+		 adapt.fixed ? "fixed" : "auto", hp_pm_break_even_ms());
+	wmprintf("windows %u: up %u down %u off %u probe %u, "
+		 "last net %d uAms\r\n", adapt.windows, adapt.up,
+		 adapt.down, adapt.off, adapt.probe, (int)adapt.last_gain);
+	wmprintf("PM2 stays:\r\n");
+	for (i = 0; i < HP_PM_BUCKETS; i++) {
+		wmprintf("  >= %3d ms: %u\r\n", from, adapt.hist[i]);
+		from = from ? from * 2 : 1;
+	}
+}
+
+static struct cli_command pm_adapt_cmds[] = {
+	{"pm-adapt", "[auto | fixed <ms> | model <idle> <pm2> <switch>]",
+	 pm_adapt_cmd},
+};
+
+int hp_pm_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(pm_adapt_cmds) / sizeof(struct cli_command);
+	     i++)
+		if (cli_register_command(&pm_adapt_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
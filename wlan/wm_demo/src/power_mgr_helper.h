@@ -13,6 +13,8 @@ void hp_pm_set_wake_status(void);
 int hp_pm_init(void);
 void hp_pm_wifi_ps_enable();
 void hp_pm_wifi_ps_disable();
+/** Register the "pm-adapt" command: adaptive PM2 threshold stats */
+int hp_pm_cli_init(void);
 #else
 static inline bool hp_pm_get_wake_status(void)
 {
@@ -27,6 +29,10 @@ static inline int hp_pm_init(void)
 
 static inline void hp_pm_wifi_ps_enable() {}
 static inline void hp_pm_wifi_ps_disable() {}
+static inline int hp_pm_cli_init(void)
+{
+	return WM_SUCCESS;
+}
 
 #endif /* APPCONFIG_PM_ENABLE */
 
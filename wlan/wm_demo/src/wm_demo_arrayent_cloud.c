@@ -11,6 +11,7 @@
 #include <appln_dbg.h>
 #include <psm.h>
 #include <app_framework.h>
+#include <wm_demo_props.h>
 
 #if APPCONFIG_DEMO_CLOUD
 #define DEVICE_CLASS	"wm_demo"
@@ -40,7 +41,6 @@
 
 /*------------------------------------------------------------*/
 
-static uint32_t curr_led_state;
 static bool is_psm_registered;
 
 static int
@@ -134,21 +134,24 @@ int do_cloud_post()
 		       &property_in_value);
 
 		if (!strcmp(property_buf,
-			    led_property)) {
-			if (curr_led_state != property_in_value) {
-				curr_led_state = property_in_value;
-				if (property_in_value == 1)
-					board_led_on(board_led_2());
-				else if (property_in_value == 0)
-					board_led_off(board_led_2());
-			}
-		}
+			    led_property) &&
+		    (property_in_value == 0 || property_in_value == 1))
+			wm_demo_prop_set_int(PROP_ID_onOff, property_in_value);
 	}
 
+	/* Nothing changed since the last update */
+	if (!wm_demo_props_dirty(PROP_CH_DEMO_CLOUD))
+		return WM_SUCCESS;
+
+	int curr_led_state = 0;
+	wm_demo_prop_get_int(PROP_ID_onOff, &curr_led_state);
 	sprintf(property_buf, "%d", curr_led_state);
 	if (ArrayentSetProperty(property, property_buf) !=  WM_SUCCESS) {
 		cl_dbg("Sending data failed");
 		err++;
+	} else {
+		wm_demo_props_clear_dirty(PROP_MASK(PROP_ID_onOff),
+					  PROP_CH_DEMO_CLOUD);
 	}
 	if (err)
 		return -WM_FAIL;
@@ -0,0 +1,507 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <httpd.h>
+#include <ftfs.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <http_admit.h>
+#include <wm_demo_assets.h>
+
+#define ASSET_NAME_LEN		31
+#define ASSET_TYPE_LEN		31
+#define ASSET_ETAG_LEN		16
+#define ASSETS_MANIFEST_MAXLEN	2048
+#define ASSET_HDR_LINE_LEN	128
+/* File data is sent one TCP segment at a time */
+#define ASSET_MSS		1460
+
+/* Versioned URLs (?v=<etag>) never change content */
+#define CACHE_VERSIONED		"public, max-age=31536000, immutable"
+/* Anything else is revalidated with If-None-Match on every use */
+#define CACHE_REVALIDATE	"no-cache"
+
+struct asset {
+	char uri[ASSET_NAME_LEN + 1];
+	char file[ASSET_NAME_LEN + 1];
+	char etag[ASSET_ETAG_LEN + 1];
+	const char *type;
+	int size;
+	bool gzip;
+};
+
+/* What we need to know from the request headers */
+struct asset_req {
+	bool gzip_ok;
+	bool not_modified;
+	bool range;		/* Range: bytes=first-last */
+	bool if_range_stale;	/* If-Range does not match: ignore Range */
+	long first;		/* -1 for a suffix range (last bytes) */
+	long last;		/* -1 for an open range (to the end) */
+};
+
+struct asset_stats {
+	unsigned full;		/* 200 */
+	unsigned partial;	/* 206 */
+	unsigned not_modified;	/* 304 */
+	unsigned refused;	/* 406, 416 */
+	unsigned errors;
+	unsigned long bytes;
+	unsigned long send_ms;
+	unsigned heap_min;	/* lowest free heap seen while sending */
+};
+
+static const char *asset_types[] = {
+	"text/html",
+	"application/javascript",
+	"text/css",
+	"image/png",
+	"image/gif",
+	"image/x-icon",
+};
+
+static struct asset assets[ASSETS_MAX];
+static struct httpd_wsgi_call asset_wsgi[ASSETS_MAX];
+static int nassets;
+static struct fs *assets_fs;
+static struct asset_stats st;
+
+/* The HTTP server handles one request at a time, so a single buffer kept
+ * out of the heap is enough to stream any file size.
+ */
+static char asset_buf[ASSET_MSS];
+
+static const struct asset *asset_find(const char *uri)
+{
+	int len = strcspn(uri, "?");
+	int i;
+
+	for (i = 0; i < nassets; i++)
+		if (!strncmp(assets[i].uri, uri, len) && !assets[i].uri[len])
+			return &assets[i];
+	return NULL;
+}
+
+/* Share the few content type strings instead of keeping a copy per asset */
+static const char *asset_type(const char *type)
+{
+	int i;
+
+	for (i = 0; i < sizeof(asset_types) / sizeof(asset_types[0]); i++)
+		if (!strcmp(asset_types[i], type))
+			return asset_types[i];
+	return "application/octet-stream";
+}
+
+/* True if the request URI is the versioned one, ending with ?v=<etag> */
+static bool asset_versioned(const struct asset *a, const char *uri)
+{
+	const char *v = strstr(uri, "?v=");
+
+	return v && !strcmp(v + 3, a->etag);
+}
+
+static bool hdr_name_is(const char *line, const char *name)
+{
+	int len = strlen(name);
+
+	return !strncasecmp(line, name, len) && line[len] == ':';
+}
+
+/* Accept-Encoding: gzip, deflate;q=0.5, *;q=0 */
+static bool hdr_accepts_gzip(const char *val)
+{
+	while (*val) {
+		const char *tok, *q;
+		int len;
+
+		while (*val == ' ' || *val == ',')
+			val++;
+		tok = val;
+		len = strcspn(tok, ";, ");
+		val += strcspn(val, ",");
+
+		if (!(len == 4 && !strncasecmp(tok, "gzip", 4)) &&
+		    !(len == 1 && *tok == '*'))
+			continue;
+
+		/* q=0 explicitly refuses the coding */
+		q = strstr(tok, "q=");
+		if (q && q < val && q[2] == '0' &&
+		    strspn(q + 3, ".0") == strcspn(q + 3, ", "))
+			continue;
+		return true;
+	}
+	return false;
+}
+
+/* If-None-Match: "etag1", W/"etag2" or If-None-Match: * */
+static bool hdr_etag_matches(const char *val, const char *etag)
+{
+	int len = strlen(etag);
+
+	while (*val) {
+		while (*val == ' ' || *val == ',')
+			val++;
+		if (*val == '*')
+			return true;
+		if (!strncmp(val, "W/", 2))
+			val += 2;
+		if (*val == '"' && !strncmp(val + 1, etag, len) &&
+		    val[len + 1] == '"')
+			return true;
+		val += strcspn(val, ",");
+	}
+	return false;
+}
+
+static bool hdr_parse_num(const char **val, long *num)
+{
+	char *end;
+
+	if (!isdigit((int)**val))
+		return false;
+	*num = strtol(*val, &end, 10);
+	*val = end;
+	return *num >= 0;
+}
+
+/* Range: bytes=0-499, bytes=500- or bytes=-500 (the last 500 bytes).
+ * Multiple ranges are not supported: the header is then ignored and the
+ * whole file sent, as is allowed.
+ */
+static void hdr_parse_range(struct asset_req *ar, const char *val)
+{
+	while (*val == ' ')
+		val++;
+	if (strncmp(val, "bytes=", 6) || strchr(val, ','))
+		return;
+	val += 6;
+
+	ar->first = ar->last = -1;
+	if (*val == '-') {
+		val++;
+		if (!hdr_parse_num(&val, &ar->last))
+			return;
+	} else {
+		if (!hdr_parse_num(&val, &ar->first) || *val++ != '-')
+			return;
+		if (*val && !hdr_parse_num(&val, &ar->last))
+			return;
+		if (ar->last >= 0 && ar->last < ar->first)
+			return;
+	}
+	ar->range = (*val == 0 || *val == ' ');
+}
+
+static void asset_parse_hdr(const struct asset *a, struct asset_req *ar,
+			    char *line)
+{
+	if (hdr_name_is(line, "Accept-Encoding"))
+		ar->gzip_ok =
+			hdr_accepts_gzip(line + sizeof("Accept-Encoding"));
+	else if (hdr_name_is(line, "If-None-Match"))
+		ar->not_modified =
+			hdr_etag_matches(line + sizeof("If-None-Match"),
+					 a->etag);
+	else if (hdr_name_is(line, "Range"))
+		hdr_parse_range(ar, line + sizeof("Range"));
+	else if (hdr_name_is(line, "If-Range"))
+		/* Only entity tags are sent as validators, not dates */
+		ar->if_range_stale =
+			!hdr_etag_matches(line + sizeof("If-Range"), a->etag);
+}
+
+/* The HTTP server dispatches the request once the request line is read.
+ * The headers are read here, one byte at a time as they are only a few
+ * hundred bytes long.
+ */
+static int asset_read_hdrs(httpd_request_t *req, const struct asset *a,
+			   struct asset_req *ar)
+{
+	char line[ASSET_HDR_LINE_LEN];
+	int n = 0;
+	char c;
+
+	memset(ar, 0, sizeof(*ar));
+	while (1) {
+		if (httpd_recv(req->sock, &c, 1, 0) != 1)
+			return -WM_FAIL;
+		if (c == '\r')
+			continue;
+		if (c != '\n') {
+			/* Overlong lines are truncated */
+			if (n < sizeof(line) - 1)
+				line[n++] = c;
+			continue;
+		}
+		if (!n)
+			break;
+		line[n] = 0;
+		asset_parse_hdr(a, ar, line);
+		n = 0;
+	}
+
+	req->hdr_parsed = 1;
+	return WM_SUCCESS;
+}
+
+/* Resolve the requested range against the file size. Returns false if it
+ * cannot be satisfied.
+ */
+static bool asset_range(const struct asset *a, struct asset_req *ar)
+{
+	if (ar->first < 0) {
+		/* Suffix range */
+		if (ar->last == 0 || !a->size)
+			return false;
+		ar->first = ar->last < a->size ? a->size - ar->last : 0;
+		ar->last = a->size - 1;
+		return true;
+	}
+	if (ar->first >= a->size)
+		return false;
+	if (ar->last < 0 || ar->last >= a->size)
+		ar->last = a->size - 1;
+	return true;
+}
+
+/* Stream len bytes of the file from offset, straight from flash to the
+ * socket, one segment at a time.
+ */
+static int asset_send_file(int sock, const struct asset *a, long offset,
+			   long len)
+{
+	unsigned long start = os_ticks_get();
+	file *f;
+	int n, ret = WM_SUCCESS;
+	unsigned heap;
+
+	f = assets_fs->fopen(assets_fs, a->file, "r");
+	if (!f)
+		return -WM_FAIL;
+	if (offset && assets_fs->fseek(f, offset, SEEK_SET) != 0) {
+		assets_fs->fclose(f);
+		return -WM_FAIL;
+	}
+
+	while (len > 0) {
+		n = assets_fs->fread(asset_buf, 1,
+				     len < ASSET_MSS ? len : ASSET_MSS, f);
+		if (n <= 0 || httpd_send(sock, asset_buf, n) != WM_SUCCESS) {
+			ret = -WM_FAIL;
+			break;
+		}
+		len -= n;
+		st.bytes += n;
+
+		heap = os_get_free_size();
+		if (!st.heap_min || heap < st.heap_min)
+			st.heap_min = heap;
+	}
+
+	assets_fs->fclose(f);
+	st.send_ms += os_ticks_to_msec(os_ticks_get() - start);
+	return ret;
+}
+
+static int asset_get_handler(httpd_request_t *req)
+{
+	const struct asset *a = asset_find(req->filename);
+	const char *cache;
+	struct asset_req ar;
+	char hdr[320];
+	int len, ret;
+
+	if (!a || asset_read_hdrs(req, a, &ar) != WM_SUCCESS)
+		return -WM_FAIL;
+
+	cache = asset_versioned(a, req->filename) ? CACHE_VERSIONED :
+		CACHE_REVALIDATE;
+
+	if (ar.not_modified) {
+		len = snprintf(hdr, sizeof(hdr),
+			       "HTTP/1.1 304 Not Modified\r\n"
+			       "ETag: \"%s\"\r\n"
+			       "Cache-Control: %s\r\n\r\n", a->etag, cache);
+		st.not_modified++;
+		return httpd_send(req->sock, hdr, len);
+	}
+
+	if (a->gzip && !ar.gzip_ok) {
+		len = snprintf(hdr, sizeof(hdr),
+			       "HTTP/1.1 406 Not Acceptable\r\n"
+			       "Vary: Accept-Encoding\r\n"
+			       "Content-Length: 0\r\n\r\n");
+		st.refused++;
+		return httpd_send(req->sock, hdr, len);
+	}
+
+	/* A stale If-Range asks for the whole, new, file */
+	if (ar.if_range_stale)
+		ar.range = false;
+	if (ar.range && !asset_range(a, &ar)) {
+		len = snprintf(hdr, sizeof(hdr),
+			       "HTTP/1.1 416 Range Not Satisfiable\r\n"
+			       "Content-Range: bytes */%d\r\n"
+			       "Content-Length: 0\r\n\r\n", a->size);
+		st.refused++;
+		return httpd_send(req->sock, hdr, len);
+	}
+	if (!ar.range) {
+		ar.first = 0;
+		ar.last = a->size - 1;
+	}
+
+	len = snprintf(hdr, sizeof(hdr),
+		       "HTTP/1.1 %s\r\n"
+		       "Content-Type: %s\r\n"
+		       "%s"
+		       "ETag: \"%s\"\r\n"
+		       "Cache-Control: %s\r\n"
+		       "Accept-Ranges: bytes\r\n",
+		       ar.range ? "206 Partial Content" : "200 OK", a->type,
+		       a->gzip ? "Content-Encoding: gzip\r\n"
+		       "Vary: Accept-Encoding\r\n" : "",
+		       a->etag, cache);
+	if (ar.range) {
+		len += snprintf(hdr + len, sizeof(hdr) - len,
+				"Content-Range: bytes %ld-%ld/%d\r\n",
+				ar.first, ar.last, a->size);
+		st.partial++;
+	} else {
+		st.full++;
+	}
+	len += snprintf(hdr + len, sizeof(hdr) - len,
+			"Content-Length: %ld\r\n\r\n",
+			ar.last - ar.first + 1);
+	if (httpd_send(req->sock, hdr, len) != WM_SUCCESS) {
+		st.errors++;
+		return -WM_FAIL;
+	}
+
+	ret = asset_send_file(req->sock, a, ar.first, ar.last - ar.first + 1);
+	if (ret != WM_SUCCESS)
+		st.errors++;
+	return ret;
+}
+
+static int asset_get(httpd_request_t *req)
+{
+	return http_admit_call(req, asset_get_handler);
+}
+
+static int assets_load_manifest(char *buf, int len)
+{
+	char *line, *next;
+
+	buf[len] = 0;
+	for (line = buf; *line && nassets < ASSETS_MAX; line = next) {
+		struct asset *a = &assets[nassets];
+		char type[ASSET_TYPE_LEN + 1];
+		int gzip;
+
+		next = line + strcspn(line, "\n");
+		if (*next)
+			*next++ = 0;
+		if (!*line)
+			continue;
+
+		if (sscanf(line, "%31s %31s %31s %d %16s %d", a->uri, a->file,
+			   type, &a->size, a->etag, &gzip) != 6 ||
+		    a->uri[0] != '/') {
+			dbg("assets: bad manifest line: %s", line);
+			continue;
+		}
+		a->type = asset_type(type);
+		a->gzip = gzip;
+		nassets++;
+	}
+	if (*line)
+		dbg("assets: manifest truncated to %d entries", ASSETS_MAX);
+
+	return nassets;
+}
+
+static void assets_stats_cmd(int argc, char **argv)
+{
+	wmprintf("assets: %d files\r\n", nassets);
+	wmprintf("200 %u 206 %u 304 %u refused %u errors %u\r\n", st.full,
+		 st.partial, st.not_modified, st.refused, st.errors);
+	wmprintf("sent %lu bytes in %lu ms (%lu KB/s)\r\n", st.bytes,
+		 st.send_ms, st.send_ms ? st.bytes / st.send_ms : 0);
+	wmprintf("buffer %d bytes (static), free heap %u, min while sending "
+		 "%u\r\n", ASSET_MSS, os_get_free_size(), st.heap_min);
+}
+
+static struct cli_command assets_cmds[] = {
+	{"assets-stats", NULL, assets_stats_cmd},
+};
+
+int wm_demo_assets_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(assets_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&assets_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+int wm_demo_assets_init(struct fs *fs)
+{
+	char *buf;
+	file *f;
+	int len, i, pass;
+
+	if (!fs)
+		return -WM_E_INVAL;
+	if (nassets)
+		return WM_SUCCESS;
+	assets_fs = fs;
+
+	f = fs->fopen(fs, ASSETS_MANIFEST, "r");
+	if (!f) {
+		dbg("assets: no %s, serving FTFS files as is",
+		    ASSETS_MANIFEST);
+		return WM_SUCCESS;
+	}
+
+	buf = os_mem_alloc(ASSETS_MANIFEST_MAXLEN + 1);
+	if (!buf) {
+		fs->fclose(f);
+		return -WM_E_NOMEM;
+	}
+	len = fs->fread(buf, 1, ASSETS_MANIFEST_MAXLEN, f);
+	fs->fclose(f);
+
+	assets_load_manifest(buf, len > 0 ? len : 0);
+	os_mem_free(buf);
+
+	/* Compressed files first: they cannot be served by the FTFS handler
+	 * if we run out of handler slots, the others only lose caching.
+	 */
+	for (pass = 1; pass >= 0; pass--) {
+		for (i = 0; i < nassets; i++) {
+			if (assets[i].gzip != pass)
+				continue;
+			asset_wsgi[i].uri = assets[i].uri;
+			asset_wsgi[i].hdr_fields = HTTPD_DEFAULT_HDR_FLAGS;
+			asset_wsgi[i].get_handler = asset_get;
+			if (httpd_register_wsgi_handler(&asset_wsgi[i]) !=
+			    WM_SUCCESS)
+				dbg("assets: failed to register %s",
+				    assets[i].uri);
+		}
+	}
+	dbg("assets: %d files", nassets);
+
+	return WM_SUCCESS;
+}
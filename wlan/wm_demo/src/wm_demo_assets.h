@@ -0,0 +1,40 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Web application assets
+ *
+ * The files of the web application are listed, with a content hash, in the
+ * assets.lst manifest of the FTFS image (see ftfs_stage.sh). This registers
+ * an HTTP handler for each of them that sends:
+ *
+ * - the hash as ETag, answering If-None-Match with "304 Not Modified";
+ * - a long lived Cache-Control for versioned URLs (?v=<hash>, as used by
+ *   index.html), "no-cache" otherwise so that the client revalidates;
+ * - large JavaScript and CSS files, stored gzip compressed only, as is
+ *   with "Content-Encoding: gzip". Clients that do not accept gzip get
+ *   "406 Not Acceptable" for these.
+ *
+ * File data is streamed from flash to the socket one TCP segment at a time
+ * through a single static buffer: serving large files takes no heap.
+ * Single byte ranges (Range, If-Range) are supported for resumed downloads.
+ * "assets-stats" prints the response counts, throughput and heap use.
+ */
+
+#ifndef _WM_DEMO_ASSETS_H_
+#define _WM_DEMO_ASSETS_H_
+
+#include <ftfs.h>
+
+#define ASSETS_MANIFEST		"assets.lst"
+#define ASSETS_MAX		24
+
+/** Read the manifest from fs and register the asset handlers. Call after
+ * the HTTP server was started.
+ */
+int wm_demo_assets_init(struct fs *fs);
+
+int wm_demo_assets_cli_init(void);
+
+#endif /* _WM_DEMO_ASSETS_H_ */
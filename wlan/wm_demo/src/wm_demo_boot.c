@@ -0,0 +1,81 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <wm_demo_boot.h>
+
+struct boot_mark {
+	const char *name;
+	uint32_t us;		/* since reset */
+};
+
+static struct boot_mark boot_marks[BOOT_MAX_MARKS];
+static int boot_nmarks;
+
+static int boot_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < boot_nmarks; i++)
+		if (boot_marks[i].name == name ||
+		    !strcmp(boot_marks[i].name, name))
+			return i;
+	return -1;
+}
+
+void wm_demo_boot_mark(const char *name)
+{
+	uint32_t us = os_get_timestamp();
+	unsigned long flags;
+
+	flags = os_enter_critical_section();
+	if (boot_nmarks < BOOT_MAX_MARKS && boot_find(name) < 0) {
+		boot_marks[boot_nmarks].name = name;
+		boot_marks[boot_nmarks].us = us;
+		boot_nmarks++;
+	}
+	os_exit_critical_section(flags);
+}
+
+int wm_demo_boot_ms(const char *name)
+{
+	int i = boot_find(name);
+
+	if (i < 0)
+		return -WM_FAIL;
+	return boot_marks[i].us / 1000;
+}
+
+static void boot_time_cmd(int argc, char **argv)
+{
+	uint32_t prev = 0;
+	int i;
+
+	wmprintf("%-20s %10s %10s\r\n", "phase", "t (ms)", "delta (ms)");
+	for (i = 0; i < boot_nmarks; i++) {
+		wmprintf("%-20s %6u.%03u %6u.%03u\r\n", boot_marks[i].name,
+			 boot_marks[i].us / 1000, boot_marks[i].us % 1000,
+			 (boot_marks[i].us - prev) / 1000,
+			 (boot_marks[i].us - prev) % 1000);
+		prev = boot_marks[i].us;
+	}
+}
+
+static struct cli_command boot_cmds[] = {
+	{"boot-time", NULL, boot_time_cmd},
+};
+
+int wm_demo_boot_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(boot_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&boot_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
@@ -0,0 +1,37 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Boot timeline
+ *
+ * Records the time since reset at which each boot phase completed, from
+ * main() to the first report sent to the cloud. Only the first occurrence
+ * of a phase is kept, so marks on paths that run again after a reconnection
+ * are harmless. The timeline is printed by the "boot-time" CLI command.
+ */
+
+#ifndef _WM_DEMO_BOOT_H_
+#define _WM_DEMO_BOOT_H_
+
+#include <wmtypes.h>
+
+#define BOOT_MAX_MARKS		24
+
+/* Phase names shared between modules */
+#define BOOT_MAIN		"main"
+#define BOOT_CONNECTED		"connected"
+#define BOOT_FIRST_REPORT	"first-report"
+
+/** Record the completion of phase name. name must be a string literal. */
+void wm_demo_boot_mark(const char *name);
+
+/** Time from reset to phase name in milliseconds, -WM_FAIL if the phase
+ * was not reached yet.
+ */
+int wm_demo_boot_ms(const char *name);
+
+/** Register the "boot-time" CLI command */
+int wm_demo_boot_cli_init(void);
+
+#endif /* _WM_DEMO_BOOT_H_ */
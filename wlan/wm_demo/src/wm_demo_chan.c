@@ -0,0 +1,324 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <app_framework.h>
+#include <httpc.h>
+#include <wm_net.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <wm_demo_wq.h>
+#include <wm_demo_chan.h>
+#include <wm_demo_netsched.h>
+
+struct chan_stats {
+	unsigned opens;
+	unsigned resumes;	/* sessions kept across a link loss */
+	unsigned failures;
+	unsigned recoveries;
+	unsigned rec_last_ms;
+	unsigned rec_max_ms;
+	unsigned long rec_sum_ms;
+};
+
+/* Time between two attempts at opening the session */
+#define CHAN_RETRY_MS		1000
+
+static struct {
+	const char *url;
+	chan_up_cb_t up_cb;
+	os_mutex_t mutex;
+	os_semaphore_t sem;	/* wakes up the receiver */
+	http_session_t hS;	/* 0 when closed */
+	bool closing;		/* hS failed, to be closed by the receiver */
+	char ip[16];		/* our address when hS was opened */
+	bool link_up;
+	bool stopped;
+	bool open_queued;	/* chan_open_work() posted */
+	bool recovering;
+	unsigned long link_up_tick;
+	struct chan_stats st;
+} ch;
+
+/* Retire the session. Only the receiving thread closes it, as it may be
+ * reading from it: the socket is shut down here so that the read returns,
+ * and the session is closed by chan_reap(). Called with ch.mutex held.
+ */
+static void chan_close(const char *why)
+{
+	if (!ch.hS || ch.closing)
+		return;
+	dbg("chan: closing session (%s)", why);
+	ch.closing = true;
+	shutdown(http_get_sockfd_from_handle(ch.hS), SHUT_RDWR);
+	os_semaphore_put(&ch.sem);
+}
+
+/* Receiving thread, with ch.mutex held */
+static void chan_reap(void)
+{
+	if (!ch.closing)
+		return;
+	http_close_session(&ch.hS);
+	ch.hS = 0;
+	ch.closing = false;
+}
+
+static void chan_retry(void *arg)
+{
+	os_semaphore_put(&ch.sem);
+}
+
+/* Retries go out with the other network jobs, not before CHAN_RETRY_MS */
+static struct netsched_job retry_job = {
+	.name = "chan-retry",
+	.fn = chan_retry,
+	.slack_ms = CHAN_RETRY_MS,
+	.late = true,
+};
+
+/* Open a session if the link is up and there is none. The connection is
+ * made without holding the mutex so that senders do not wait for it.
+ * Work queue only: the name lookup and the connection need more stack
+ * than the receiving thread has.
+ */
+static bool chan_open(void)
+{
+	http_session_t hS;
+	char ip[16];
+	int ret;
+
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	ret = !ch.stopped && ch.link_up && !ch.hS;
+	os_mutex_put(&ch.mutex);
+	if (!ret)
+		return false;
+
+	app_network_ip_get(ip);
+	ret = http_open_session(&hS, ch.url, 0, NULL, 0);
+	dbg("chan: http_open_session status: %d", ret);
+	if (ret != WM_SUCCESS) {
+		wm_demo_netsched_start(&retry_job, CHAN_RETRY_MS);
+		return false;
+	}
+
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	if (ch.stopped || !ch.link_up || ch.hS) {
+		http_close_session(&hS);
+		ret = -WM_FAIL;
+	} else {
+		ch.hS = hS;
+		strncpy(ch.ip, ip, sizeof(ch.ip) - 1);
+		ch.st.opens++;
+	}
+	os_mutex_put(&ch.mutex);
+
+	return ret == WM_SUCCESS;
+}
+
+static void chan_open_work(void *arg)
+{
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	ch.open_queued = false;
+	os_mutex_put(&ch.mutex);
+
+	if (!chan_open())
+		return;
+	os_semaphore_put(&ch.sem);
+	if (ch.up_cb)
+		ch.up_cb();
+}
+
+/* Have a session opened if one is needed. Called with ch.mutex held. */
+static void chan_kick_open(void)
+{
+	if (ch.stopped || !ch.link_up || ch.hS || ch.open_queued)
+		return;
+	if (wm_demo_wq_post(WQ_PRIO_HIGH, chan_open_work, NULL)
+	    == WM_SUCCESS)
+		ch.open_queued = true;
+	else
+		wm_demo_netsched_start(&retry_job, CHAN_RETRY_MS);
+}
+
+static void chan_resume_work(void *arg)
+{
+	if (ch.up_cb)
+		ch.up_cb();
+}
+
+void wm_demo_chan_link_up(void)
+{
+	char ip[16];
+	bool resumed = false;
+
+	app_network_ip_get(ip);
+
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	ch.stopped = false;
+	if (!ch.link_up) {
+		ch.link_up = true;
+		ch.recovering = true;
+		ch.link_up_tick = os_ticks_get();
+	}
+	if (ch.hS && strcmp(ip, ch.ip)) {
+		/* The server cannot reach the old address any more */
+		chan_close("address changed");
+		ch.st.failures++;
+	} else if (ch.hS) {
+		ch.st.resumes++;
+		resumed = true;
+	}
+	os_mutex_put(&ch.mutex);
+
+	if (resumed)
+		wm_demo_wq_post(WQ_PRIO_HIGH, chan_resume_work, NULL);
+	/* The receiver waits for the link while it is down */
+	os_semaphore_put(&ch.sem);
+}
+
+void wm_demo_chan_link_down(void)
+{
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	ch.link_up = false;
+	os_mutex_put(&ch.mutex);
+}
+
+void wm_demo_chan_stop(void)
+{
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	ch.stopped = true;
+	ch.link_up = false;
+	ch.recovering = false;
+	chan_close("stopped");
+	os_mutex_put(&ch.mutex);
+	wm_demo_netsched_stop(&retry_job);
+}
+
+int wm_demo_chan_send(const char *buf, int len)
+{
+	int ret = WM_SUCCESS;
+
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	if (!ch.link_up || !ch.hS || ch.closing) {
+		ret = -WM_E_AGAIN;
+	} else if (http_lowlevel_write(ch.hS, buf, len) != len) {
+		chan_close("write failed");
+		ch.st.failures++;
+		ret = -WM_FAIL;
+	}
+	os_mutex_put(&ch.mutex);
+
+	if (ret == WM_SUCCESS)
+		wm_demo_netsched_radio_busy();
+	return ret;
+}
+
+static void chan_recovered(void)
+{
+	unsigned ms;
+
+	if (!ch.recovering)
+		return;
+	ch.recovering = false;
+
+	ms = os_ticks_to_msec(os_ticks_get() - ch.link_up_tick);
+	ch.st.recoveries++;
+	ch.st.rec_last_ms = ms;
+	ch.st.rec_sum_ms += ms;
+	if (ms > ch.st.rec_max_ms)
+		ch.st.rec_max_ms = ms;
+	dbg("chan: recovered %u ms after link up", ms);
+}
+
+int wm_demo_chan_recv(char *buf, int len)
+{
+	http_session_t hS;
+	int n;
+
+	/* The session stays open until this thread closes it */
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	chan_reap();
+	chan_kick_open();
+	hS = ch.link_up && !ch.closing ? ch.hS : 0;
+	os_mutex_put(&ch.mutex);
+
+	/* Woken by a link change, a close, a retry or a new session */
+	if (!hS) {
+		os_semaphore_get(&ch.sem, OS_WAIT_FOREVER);
+		return 0;
+	}
+
+	n = http_lowlevel_read(hS, buf, len);
+
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	if (n > 0) {
+		chan_recovered();
+	} else {
+		if (!ch.closing)
+			ch.st.failures++;
+		chan_close("read failed");
+		chan_reap();
+	}
+	os_mutex_put(&ch.mutex);
+
+	return n > 0 ? n : 0;
+}
+
+static void chan_stats_cmd(int argc, char **argv)
+{
+	struct chan_stats st;
+	const char *state;
+
+	os_mutex_get(&ch.mutex, OS_WAIT_FOREVER);
+	st = ch.st;
+	if (!ch.hS)
+		state = "down";
+	else if (ch.closing)
+		state = "closing";
+	else
+		state = ch.link_up ? "up" : "suspended";
+	os_mutex_put(&ch.mutex);
+
+	wmprintf("state: %s\r\n", state);
+	wmprintf("opens %u resumes %u failures %u\r\n", st.opens, st.resumes,
+		 st.failures);
+	wmprintf("recoveries %u last %u ms max %u ms avg %u ms\r\n",
+		 st.recoveries, st.rec_last_ms, st.rec_max_ms,
+		 st.recoveries ? (unsigned)(st.rec_sum_ms / st.recoveries) : 0);
+}
+
+static struct cli_command chan_cmds[] = {
+	{"chan-stats", NULL, chan_stats_cmd},
+};
+
+int wm_demo_chan_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(chan_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&chan_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+int wm_demo_chan_init(const char *url, chan_up_cb_t up_cb)
+{
+	int ret;
+
+	ch.url = url;
+	ch.up_cb = up_cb;
+
+	ret = os_mutex_create(&ch.mutex, "chan", OS_MUTEX_INHERIT);
+	if (ret != WM_SUCCESS)
+		return ret;
+	ret = os_semaphore_create(&ch.sem, "chan");
+	if (ret != WM_SUCCESS)
+		return ret;
+	/* Start with the semaphore taken */
+	os_semaphore_get(&ch.sem, OS_WAIT_FOREVER);
+	return WM_SUCCESS;
+}
@@ -0,0 +1,55 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Device channel session
+ *
+ * Owns the TCP session to the device channel server. A link loss only
+ * suspends the channel: the session is kept open and, when the link comes
+ * back with the same IP address, it is used again right away instead of
+ * being torn down and reopened. The session is reopened only when it
+ * actually fails or the address changed.
+ *
+ * Nothing is lost while the channel is down: reports are driven by the
+ * property dirty masks, which are only cleared once a send succeeded.
+ *
+ * The recovery latency (link up to the first message received from the
+ * server) is measured and printed by the "chan-stats" CLI command.
+ */
+
+#ifndef _WM_DEMO_CHAN_H_
+#define _WM_DEMO_CHAN_H_
+
+#include <wmtypes.h>
+
+/** Called from the work queue every time a session becomes usable,
+ * typically to send the pending reports.
+ */
+typedef void (*chan_up_cb_t)(void);
+
+int wm_demo_chan_init(const char *url, chan_up_cb_t up_cb);
+
+/** Station connected or DHCP lease renewed: resume or (re)open */
+void wm_demo_chan_link_up(void);
+
+/** Link lost: suspend, keeping the session */
+void wm_demo_chan_link_down(void);
+
+/** Close the session for good, e.g. on reset to provisioning */
+void wm_demo_chan_stop(void);
+
+/** Send a message. Returns -WM_E_AGAIN if the channel is not usable now;
+ * the caller should retry when the up callback runs.
+ */
+int wm_demo_chan_send(const char *buf, int len);
+
+/** Receive the next message. Has the session opened if needed. Returns the
+ * number of bytes read, or 0 if the channel is not usable (after waiting
+ * for the link to change or for the next attempt at opening the session).
+ */
+int wm_demo_chan_recv(char *buf, int len);
+
+int wm_demo_chan_cli_init(void);
+
+#endif /* _WM_DEMO_CHAN_H_ */
@@ -3,68 +3,93 @@
  *  All Rights Reserved.
  */
 #include <wmstdio.h>
+#include <string.h>
 #include <wm_os.h>
 #include <json.h>
 #include <board.h>
 #include <appln_dbg.h>
 
 #include <wmcloud_lp_ws.h>
+#include <wm_demo_props.h>
 #define J_NAME_WM_DEMO	"wm_demo"
-#define J_NAME_STATE          "led_state"
+/* onOff, under the name servers of the first protocol version know */
+#define J_NAME_STATE	"led_state"
 
 #if APPCONFIG_DEMO_CLOUD
 #include <wmcloud.h>
 #define DEVICE_CLASS	"wm_demo"
 #endif  /* APPCONFIG_DEMO_CLOUD */
-static int led_state;
 
-void wm_demo_periodic_post(struct json_str *jstr)
+/* Properties in the packet being posted, reported again if it fails */
+static unsigned posted;
+
+static void wm_demo_encode(struct json_str *jstr, unsigned mask)
 {
+	int on;
+
 	json_push_object(jstr, J_NAME_WM_DEMO);
-	json_set_val_int(jstr, J_NAME_STATE, led_state);
+	wm_demo_props_encode(jstr, mask, PROP_CH_DEMO_CLOUD);
+	if ((mask & PROP_MASK(PROP_ID_onOff)) &&
+	    wm_demo_prop_get_int(PROP_ID_onOff, &on) == WM_SUCCESS)
+		json_set_val_int(jstr, J_NAME_STATE, on);
 	json_pop_object(jstr);
+	posted |= mask;
 }
 
-void
-wm_demo_handle_req(struct json_str *jstr, struct json_object *obj,
-			bool *repeat_POST)
+void wm_demo_periodic_post(struct json_str *jstr)
 {
+	unsigned mask = wm_demo_props_dirty(PROP_CH_DEMO_CLOUD);
 
-	char buf[16];
-	bool flag = false;
-	int req_state;
+	if (!mask)
+		return;
+	wm_demo_encode(jstr, mask);
+}
 
-	if (json_get_composite_object(obj, J_NAME_WM_DEMO) == WM_SUCCESS) {
-		if (json_get_val_str(obj, J_NAME_STATE, buf, 16)
-		    == WM_SUCCESS) {
-			if (!strncmp(buf, QUERY_STR, 16)) {
-				dbg("led state query");
-				*repeat_POST = flag = true;
-			}
-		} else if (json_get_val_int(obj, J_NAME_STATE, &req_state) ==
-			   WM_SUCCESS) {
-			if (req_state == 0) {
-				dbg("led state off");
-				board_led_off(board_led_2());
-				led_state = 0;
-				*repeat_POST = flag = true;
-			} else if (req_state == 1) {
-				dbg("led state on");
-				board_led_on(board_led_2());
-				led_state = 1;
-				*repeat_POST = flag = true;
-			}
+static void wm_demo_post_done(int status)
+{
+	if (status != WM_SUCCESS)
+		wm_demo_props_mark_dirty(posted, PROP_CH_DEMO_CLOUD);
+	posted = 0;
+}
 
-		}
+/* Set or query onOff through its old name */
+static unsigned wm_demo_legacy_req(struct json_object *obj)
+{
+	char buf[16];
+	int state;
 
-		if (flag) {
-			json_push_object(jstr, J_NAME_WM_DEMO);
-			json_set_val_int(jstr, J_NAME_STATE,
-					 led_state);
-			json_pop_object(jstr);
-		}
+	if (json_get_val_str(obj, J_NAME_STATE, buf, sizeof(buf))
+	    == WM_SUCCESS) {
+		if (strncmp(buf, QUERY_STR, sizeof(buf)))
+			return 0;
+		dbg("led state query");
+		return PROP_MASK(PROP_ID_onOff);
 	}
+	if (json_get_val_int(obj, J_NAME_STATE, &state) != WM_SUCCESS ||
+	    (state != 0 && state != 1))
+		return 0;
+	dbg("led state %s", state ? "on" : "off");
+	if (wm_demo_prop_set_int(PROP_ID_onOff, state) != WM_SUCCESS)
+		return 0;
+	return PROP_MASK(PROP_ID_onOff);
+}
+
+void
+wm_demo_handle_req(struct json_str *jstr, struct json_object *obj,
+			bool *repeat_POST)
+{
+	unsigned mask;
+
+	if (json_get_composite_object(obj, J_NAME_WM_DEMO) != WM_SUCCESS)
+		return;
+
+	mask = wm_demo_props_decode(obj) | wm_demo_legacy_req(obj);
+	json_release_composite_object(obj);
+	if (!mask)
+		return;
 
+	*repeat_POST = true;
+	wm_demo_encode(jstr, mask);
 }
 
 #if APPCONFIG_DEMO_CLOUD
@@ -72,6 +97,7 @@ void wm_demo_cloud_start()
 {
 	int ret;
 	/* Starting cloud thread if enabled */
+	cloud_set_post_done(wm_demo_post_done);
 	ret = cloud_start(DEVICE_CLASS, wm_demo_handle_req,
 		wm_demo_periodic_post);
 	if (ret != WM_SUCCESS)
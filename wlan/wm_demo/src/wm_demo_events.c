@@ -0,0 +1,409 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <wm_net.h>
+#include <string.h>
+#include <json.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <wm_demo_props.h>
+#include <wm_demo_events.h>
+#include <wm_demo_netsched.h>
+#include <wm_demo_wq.h>
+#include <wake_audit.h>
+
+/* Comment line sent on the streams, to find out about dead clients. It
+ * goes out with other traffic, up to EVENTS_PING_SLACK_MS early.
+ */
+#define EVENTS_PING_MS		15000
+#define EVENTS_PING_SLACK_MS	5000
+#define EVENTS_BUF_LEN		(sizeof("event: props\ndata: {}\n\n") + \
+				 WM_DEMO_PROPS_MAXLEN)
+#define EVENTS_CONN_DOWN	"down"
+
+static const char events_hdrs[] =
+	"HTTP/1.1 200 OK\r\n"
+	"Content-Type: text/event-stream\r\n"
+	"Cache-Control: no-cache\r\n"
+	"Access-Control-Allow-Origin: *\r\n"
+	"Connection: keep-alive\r\n\r\n"
+	"retry: 3000\n\n";
+
+static const char events_busy[] =
+	"HTTP/1.1 503 Service Unavailable\r\n"
+	"Retry-After: 5\r\n"
+	"Access-Control-Allow-Origin: *\r\n"
+	"Content-Length: 0\r\n\r\n";
+
+struct subscriber {
+	int sock;		/* -1 if the slot is free */
+	bool active;		/* request read, stream started */
+	bool dead;		/* send failed, to be closed */
+	int eoh;		/* bytes of the "\r\n\r\n" ending the request
+				 * matched so far */
+};
+
+struct events_stats {
+	unsigned subscribed;
+	unsigned refused;
+	unsigned dropped;
+	unsigned events;
+};
+
+/* Subscribers are accepted, read and closed by the events thread. Events
+ * are pushed from the work queue, as soon as something changes, so that
+ * the thread sleeps until a client connects or sends something. The mutex
+ * keeps the two apart.
+ */
+static struct {
+	int listen_sock;
+	os_mutex_t mutex;
+	struct subscriber sub[EVENTS_MAX_SUBSCRIBERS];
+	/* Set by wm_demo_events_conn(), from any thread. A pointer and a
+	 * flag, each written in one go: no lock needed.
+	 */
+	const char *volatile conn;
+	volatile bool conn_changed;
+	volatile bool ping_due;
+	volatile bool push_queued;	/* events_push_work() posted */
+	struct events_stats st;
+} ev = {
+	.listen_sock = -1,
+	.conn = EVENTS_CONN_DOWN,
+};
+
+static os_thread_t events_thread;
+static os_thread_stack_define(events_stack, 1024);
+static char events_buf[EVENTS_BUF_LEN];
+
+static void events_push_work(void *arg);
+
+/* Have the changes pushed. May run in any thread, never blocks. */
+static void events_kick(void)
+{
+	unsigned long flags;
+	bool queued;
+
+	/* Not started, or failed to */
+	if (ev.listen_sock < 0)
+		return;
+
+	flags = os_enter_critical_section();
+	queued = ev.push_queued;
+	ev.push_queued = true;
+	os_exit_critical_section(flags);
+	if (!queued && wm_demo_wq_post(WQ_PRIO_LOW, events_push_work, NULL)
+	    != WM_SUCCESS)
+		ev.push_queued = false;
+}
+
+void wm_demo_events_conn(const char *state)
+{
+	ev.conn = state;
+	ev.conn_changed = true;
+	events_kick();
+}
+
+/* Events thread only */
+static void events_drop(struct subscriber *s)
+{
+	net_close(s->sock);
+	s->sock = -1;
+	if (s->active)
+		ev.st.dropped++;
+	s->active = false;
+	s->dead = false;
+}
+
+/* Sockets do not block: a client too slow to take an event in full is
+ * dropped, it would otherwise hold up the others. The socket is only shut
+ * down here, the events thread sees it and closes it.
+ */
+static bool events_send(struct subscriber *s, const char *buf, int len)
+{
+	if (send(s->sock, buf, len, 0) == len)
+		return true;
+	if (s->active)
+		ev.st.dropped++;
+	s->active = false;
+	s->dead = true;
+	shutdown(s->sock, SHUT_RDWR);
+	return false;
+}
+
+static void events_broadcast(const char *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < EVENTS_MAX_SUBSCRIBERS; i++)
+		if (ev.sub[i].active)
+			events_send(&ev.sub[i], buf, len);
+}
+
+/* Properties in mask, cleared from the dirty mask of channel ch */
+static int events_fmt_props(unsigned mask, unsigned ch)
+{
+	struct json_str jstr;
+	int len = sizeof("event: props\ndata: ") - 1;
+
+	memcpy(events_buf, "event: props\ndata: ", len);
+	json_str_init(&jstr, events_buf + len, sizeof(events_buf) - len - 2,
+		      0);
+	json_start_object(&jstr);
+	wm_demo_props_encode(&jstr, mask, ch);
+	json_close_object(&jstr);
+	len += strlen(events_buf + len);
+
+	memcpy(events_buf + len, "\n\n", 2);
+	ev.st.events++;
+	return len + 2;
+}
+
+static int events_fmt_conn(const char *state)
+{
+	ev.st.events++;
+	return snprintf(events_buf, sizeof(events_buf),
+			"event: conn\ndata: {\"state\":\"%s\"}\n\n", state);
+}
+
+/* Start the stream with the complete device state */
+static void events_start(struct subscriber *s)
+{
+	if (!events_send(s, events_hdrs, sizeof(events_hdrs) - 1))
+		return;
+	if (!events_send(s, events_buf, events_fmt_props(PROP_MASK_ALL, 0)))
+		return;
+	if (!events_send(s, events_buf, events_fmt_conn(ev.conn)))
+		return;
+	s->active = true;
+	ev.st.subscribed++;
+}
+
+static void events_accept(void)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	int sock, i, on = 1;
+
+	sock = net_accept(ev.listen_sock, (struct sockaddr *)&addr, &len);
+	if (sock < 0)
+		return;
+	ioctlsocket(sock, FIONBIO, &on);
+
+	for (i = 0; i < EVENTS_MAX_SUBSCRIBERS; i++) {
+		if (ev.sub[i].sock < 0) {
+			ev.sub[i].sock = sock;
+			ev.sub[i].active = false;
+			ev.sub[i].eoh = 0;
+			return;
+		}
+	}
+
+	send(sock, events_busy, sizeof(events_busy) - 1, 0);
+	net_close(sock);
+	ev.st.refused++;
+}
+
+/* The request itself does not matter, it is read up to its end and
+ * dropped. Subscribers are not expected to send anything after that: data
+ * is ignored and the end of the connection detected.
+ */
+static void events_read(struct subscriber *s)
+{
+	static const char eoh[] = "\r\n\r\n";
+	char buf[64];
+	int n, i;
+
+	n = recv(s->sock, buf, sizeof(buf), 0);
+	if (n <= 0 || s->dead) {
+		events_drop(s);
+		return;
+	}
+	if (s->active)
+		return;
+
+	for (i = 0; i < n; i++) {
+		if (buf[i] == eoh[s->eoh])
+			s->eoh++;
+		else
+			s->eoh = buf[i] == '\r' ? 1 : 0;
+		if (s->eoh == sizeof(eoh) - 1) {
+			events_start(s);
+			return;
+		}
+	}
+}
+
+static void events_push(void)
+{
+	unsigned mask = wm_demo_props_dirty(PROP_CH_LOCAL);
+
+	if (mask)
+		events_broadcast(events_buf, events_fmt_props(mask,
+							      PROP_CH_LOCAL));
+	if (ev.conn_changed) {
+		ev.conn_changed = false;
+		events_broadcast(events_buf, events_fmt_conn(ev.conn));
+	}
+	if (ev.ping_due) {
+		ev.ping_due = false;
+		events_broadcast(":\n\n", 3);
+	}
+}
+
+static void events_push_work(void *arg)
+{
+	os_mutex_get(&ev.mutex, OS_WAIT_FOREVER);
+	ev.push_queued = false;
+	events_push();
+	os_mutex_put(&ev.mutex);
+}
+
+/* Run by the network scheduler, on the work queue */
+static void events_ping(void *arg)
+{
+	ev.ping_due = true;
+	events_push_work(NULL);
+}
+
+static struct netsched_job ping_job = {
+	.name = "sse-ping",
+	.fn = events_ping,
+	.period_ms = EVENTS_PING_MS,
+	.slack_ms = EVENTS_PING_SLACK_MS,
+};
+
+static void events_main(os_thread_arg_t arg)
+{
+	fd_set rfds;
+	int i, maxfd;
+	bool active, pinging = false;
+	static struct wake_point wp = {"events"};
+	int ret;
+
+	while (1) {
+		FD_ZERO(&rfds);
+		FD_SET(ev.listen_sock, &rfds);
+		maxfd = ev.listen_sock;
+		for (i = 0; i < EVENTS_MAX_SUBSCRIBERS; i++) {
+			if (ev.sub[i].sock < 0)
+				continue;
+			FD_SET(ev.sub[i].sock, &rfds);
+			if (ev.sub[i].sock > maxfd)
+				maxfd = ev.sub[i].sock;
+		}
+
+		/* Changes are pushed from the work queue: sleep until a
+		 * client connects, sends something or goes away
+		 */
+		ret = net_select(maxfd + 1, &rfds, NULL, NULL, NULL);
+
+		os_mutex_get(&ev.mutex, OS_WAIT_FOREVER);
+		if (ret > 0) {
+			if (FD_ISSET(ev.listen_sock, &rfds))
+				events_accept();
+			for (i = 0; i < EVENTS_MAX_SUBSCRIBERS; i++)
+				if (ev.sub[i].sock >= 0 &&
+				    FD_ISSET(ev.sub[i].sock, &rfds))
+					events_read(&ev.sub[i]);
+		}
+
+		active = false;
+		for (i = 0; i < EVENTS_MAX_SUBSCRIBERS; i++)
+			active |= ev.sub[i].active;
+		os_mutex_put(&ev.mutex);
+
+		/* Pings only while someone listens */
+		if (active != pinging) {
+			pinging = active;
+			if (active)
+				wm_demo_netsched_start(&ping_job,
+						       EVENTS_PING_MS);
+			else
+				wm_demo_netsched_stop(&ping_job);
+		}
+
+		wake_audit(&wp, WAKE_MSG, ret > 0);
+	}
+}
+
+static void events_stats_cmd(int argc, char **argv)
+{
+	int i, n = 0;
+
+	for (i = 0; i < EVENTS_MAX_SUBSCRIBERS; i++)
+		if (ev.sub[i].active)
+			n++;
+
+	wmprintf("port %d, %d/%d subscribers, connection %s\r\n",
+		 EVENTS_PORT, n, EVENTS_MAX_SUBSCRIBERS, ev.conn);
+	wmprintf("subscribed %u refused %u dropped %u events %u\r\n",
+		 ev.st.subscribed, ev.st.refused, ev.st.dropped,
+		 ev.st.events);
+}
+
+static struct cli_command events_cmds[] = {
+	{"events-stats", NULL, events_stats_cmd},
+};
+
+int wm_demo_events_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(events_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&events_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+/* Needs the network stack: call once the WLAN is initialized */
+int wm_demo_events_init(void)
+{
+	struct sockaddr_in addr;
+	int i, ret;
+
+	if (ev.listen_sock >= 0)
+		return WM_SUCCESS;
+
+	for (i = 0; i < EVENTS_MAX_SUBSCRIBERS; i++)
+		ev.sub[i].sock = -1;
+
+	ret = os_mutex_create(&ev.mutex, "events", OS_MUTEX_INHERIT);
+	if (ret != WM_SUCCESS)
+		return ret;
+
+	ev.listen_sock = net_socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (ev.listen_sock < 0) {
+		dbg("events: socket failed");
+		return -WM_FAIL;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(EVENTS_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (net_bind(ev.listen_sock, (struct sockaddr *)&addr,
+		     sizeof(addr)) < 0 ||
+	    net_listen(ev.listen_sock, EVENTS_MAX_SUBSCRIBERS) < 0) {
+		dbg("events: cannot listen on port %d", EVENTS_PORT);
+		goto fail;
+	}
+
+	ret = os_thread_create(&events_thread, "events", events_main, 0,
+			       &events_stack, OS_PRIO_3);
+	if (ret != WM_SUCCESS) {
+		dbg("events: thread creation failed: %d", ret);
+		goto fail;
+	}
+	if (wm_demo_props_add_notify(events_kick) != WM_SUCCESS)
+		dbg("events: no room for the property change callback");
+	return WM_SUCCESS;
+
+fail:
+	net_close(ev.listen_sock);
+	ev.listen_sock = -1;
+	return -WM_FAIL;
+}
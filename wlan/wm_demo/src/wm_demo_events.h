@@ -0,0 +1,43 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Local device state push (Server-Sent Events)
+ *
+ * A small server on EVENTS_PORT streams device state changes to local
+ * clients as they happen, so that they do not need to poll /hello or
+ * /sys. Any GET on the port subscribes, e.g. from a browser:
+ *
+ *   new EventSource("http://<ip>:8081/events")
+ *
+ * Two kinds of events are sent:
+ *
+ *   event: props		data: {"onOff":1}
+ *   event: conn		data: {"state":"connected"}
+ *
+ * A new subscriber first gets the complete state, then only changes.
+ * Property changes are picked up through their own dirty bit
+ * (PROP_CH_LOCAL), so nothing is missed while there is no subscriber.
+ *
+ * At most EVENTS_MAX_SUBSCRIBERS clients are served at a time; others get
+ * "503 Service Unavailable". The server runs in its own thread and does
+ * not load the HTTP server.
+ */
+
+#ifndef _WM_DEMO_EVENTS_H_
+#define _WM_DEMO_EVENTS_H_
+
+#define EVENTS_PORT		8081
+#define EVENTS_MAX_SUBSCRIBERS	3
+
+int wm_demo_events_init(void);
+
+/** Report a connection state change, e.g. "connected" or "link_lost".
+ * state must be a string constant.
+ */
+void wm_demo_events_conn(const char *state);
+
+int wm_demo_events_cli_init(void);
+
+#endif /* _WM_DEMO_EVENTS_H_ */
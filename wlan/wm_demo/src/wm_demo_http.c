@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Web-Service handlers of the application
+ *
+ * Kept apart from main.c so that they can also be built and load tested on
+ * a host, see tools/httpd_host.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <httpd.h>
+#include <json.h>
+#include <wm_net.h>
+#include <wmcloud.h>
+#include <appln_dbg.h>
+#include <mdns_helper.h>
+#include <wm_demo_props.h>
+#include <wm_demo_msg.h>
+#include <wm_demo_lan.h>
+#include <http_resp.h>
+#include <http_admit.h>
+#include <wm_demo_http.h>
+
+/*
+ * A simple HTTP Web-Service Handler
+ *
+ * Returns the serial number and the device properties as JSON when a GET
+ * on http://<IP>/hello is done.
+ */
+int hello_handler(httpd_request_t *req)
+{
+	struct http_resp r;
+	struct json_str *jstr;
+	int ret;
+
+	ret = http_resp_begin(&r, req, HTTP_CONTENT_PLAIN_TEXT_STR);
+	if (ret != WM_SUCCESS)
+		return ret;
+
+	jstr = http_resp_json_begin(&r);
+	json_start_object(jstr);
+	json_set_val_str(jstr, "snId", wm_demo_sn_id());
+	wm_demo_props_encode(jstr, PROP_MASK_ALL, 0);
+	json_close_object(jstr);
+	http_resp_json_end(&r);
+
+	return http_resp_send(&r, HTTP_RES_200);
+}
+
+static int wm_demo_get_ui_link(httpd_request_t *req)
+{
+	return cloud_get_ui_link(req);
+}
+
+int set_dev_seckey(httpd_request_t *req)
+{
+	struct http_resp r;
+	struct json_object obj;
+	char *dev_seckey;
+	bool handled = false;
+	int ret;
+
+	ret = http_resp_begin(&r, req, HTTP_CONTENT_JSON_STR);
+	if (ret != WM_SUCCESS)
+		return ret;
+
+	ret = http_resp_get_json(&r, &obj, 64);
+	if (ret < 0) {
+		dbg("Failed to get post request data");
+		http_resp_abort(&r);
+		return ret;
+	}
+	dev_seckey = http_resp_alloc(&r, 64);
+	if (dev_seckey &&
+	    json_get_val_str(&obj, "secKey", dev_seckey, 64) == WM_SUCCESS)
+	{
+		/* Also the key of the local control protocol. Refused once
+		 * the device is provisioned: nothing authenticates it.
+		 */
+		ret = wm_demo_lan_set_key(dev_seckey);
+		if (ret == WM_SUCCESS) {
+			dbg("recvd seckey is %s", dev_seckey);
+			hp_mdns_deannounce(net_get_uap_handle());
+			handled = true;
+		} else {
+			dbg("Device key not taken: %d", ret);
+		}
+	}
+	/* Local control of the device properties */
+	if (wm_demo_props_decode(&obj))
+		handled = true;
+
+	http_resp_printf(&r, "%s",
+			 handled ? HTTPD_JSON_SUCCESS : HTTPD_JSON_ERROR);
+	return http_resp_send(&r, HTTP_RES_200);
+}
+
+/* The handlers as registered, behind admission control */
+static int hello_get(httpd_request_t *req)
+{
+	return http_admit_call(req, hello_handler);
+}
+
+static int hello_post(httpd_request_t *req)
+{
+	return http_admit_call(req, set_dev_seckey);
+}
+
+static int cloud_ui_get(httpd_request_t *req)
+{
+	return http_admit_call(req, wm_demo_get_ui_link);
+}
+
+struct httpd_wsgi_call wm_demo_http_handlers[] = {
+	{"/hello", HTTPD_DEFAULT_HDR_FLAGS, 0,
+	hello_get, hello_post, NULL, NULL},
+	{"/cloud_ui", HTTPD_DEFAULT_HDR_FLAGS | HTTPD_HDR_ADD_PRAGMA_NO_CACHE,
+	0, cloud_ui_get, NULL, NULL, NULL},
+};
+
+static int wm_demo_handlers_no =
+	sizeof(wm_demo_http_handlers) / sizeof(struct httpd_wsgi_call);
+
+/*
+ * Register Web-Service handlers
+ *
+ */
+int register_httpd_handlers()
+{
+	if (http_resp_init() != WM_SUCCESS ||
+	    http_admit_init() != WM_SUCCESS)
+		return -WM_FAIL;
+	return httpd_register_wsgi_handlers(wm_demo_http_handlers,
+		wm_demo_handlers_no);
+}
@@ -0,0 +1,17 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+#ifndef _WM_DEMO_HTTP_H_
+#define _WM_DEMO_HTTP_H_
+
+#include <httpd.h>
+
+int hello_handler(httpd_request_t *req);
+int set_dev_seckey(httpd_request_t *req);
+
+/** Register the /hello and /cloud_ui handlers */
+int register_httpd_handlers();
+
+#endif /* _WM_DEMO_HTTP_H_ */
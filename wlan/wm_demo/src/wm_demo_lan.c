@@ -0,0 +1,584 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <wm_net.h>
+#include <wm_utils.h>
+#include <wmcrypto.h>
+#include <string.h>
+#include <psm.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <wm_demo_props.h>
+#include <wm_demo_lan.h>
+#include <wm_demo_wq.h>
+#include <wake_audit.h>
+
+#define NETWORK_MOD_NAME	"network"
+#define VAR_DEV_SECKEY		"dev_seckey"
+#define VAR_PROV_KEY		"prov_key"
+#define LAN_KEY_MAXLEN		64
+
+struct lan_peer {
+	struct sockaddr_in addr;	/* sin_port is 0 if the slot is free */
+	uint32_t session;
+	uint32_t rx_seq;		/* last sequence number accepted */
+	uint32_t tx_seq;
+	unsigned long seen;		/* ticks of the last request */
+	unsigned long sub_until;	/* ticks, subscribed if in the future */
+	bool subscribed;
+};
+
+struct lan_stats {
+	unsigned rx;
+	unsigned tx;
+	unsigned bad_tag;
+	unsigned replayed;
+	unsigned no_session;
+	unsigned notified;
+};
+
+/* Requests are handled by the lan thread, notifications are sent from the
+ * work queue when a property changes. The mutex keeps the two apart.
+ */
+static struct {
+	int sock;
+	os_mutex_t mutex;
+	char key[LAN_KEY_MAXLEN + 1];
+	int key_len;
+	/* Set by wm_demo_lan_set_key() from the HTTP server thread */
+	volatile bool key_changed;
+	volatile bool key_open;		/* wm_demo_lan_open_key() */
+	struct lan_peer peer[LAN_MAX_PEERS];
+	uint32_t nonce;			/* for the next HELLO */
+	volatile bool notify_queued;	/* lan_notify_work() posted */
+	struct lan_stats st;
+} lan = {
+	.sock = -1,
+};
+
+static os_thread_t lan_thread;
+static os_thread_stack_define(lan_stack, 2048);
+static uint8_t rx_buf[LAN_PKT_LEN];
+static uint8_t tx_buf[LAN_PKT_LEN];
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+		(uint32_t)p[2] << 8 | p[3];
+}
+
+/* The device key, or the provisioning key if none was set */
+static void lan_load_key(void)
+{
+	lan.key_changed = false;
+	memset(lan.peer, 0, sizeof(lan.peer));
+
+	if (psm_get_single(NETWORK_MOD_NAME, VAR_DEV_SECKEY, lan.key,
+			   sizeof(lan.key)) != WM_SUCCESS || !lan.key[0])
+		if (psm_get_single(NETWORK_MOD_NAME, VAR_PROV_KEY, lan.key,
+				   sizeof(lan.key)) != WM_SUCCESS)
+			lan.key[0] = 0;
+	lan.key_len = strlen(lan.key);
+	if (!lan.key_len)
+		dbg("lan: no key, local control disabled");
+}
+
+void wm_demo_lan_open_key(bool open)
+{
+	lan.key_open = open;
+}
+
+int wm_demo_lan_set_key(const char *key)
+{
+	char cur[LAN_KEY_MAXLEN + 1];
+
+	if (!lan.key_open)
+		return -WM_E_PERM;
+	if (strlen(key) > LAN_KEY_MAXLEN)
+		return -WM_E_INVAL;
+	/* Spare the flash when the client sends the same key again */
+	if (psm_get_single(NETWORK_MOD_NAME, VAR_DEV_SECKEY, cur,
+			   sizeof(cur)) == WM_SUCCESS && !strcmp(cur, key))
+		return WM_SUCCESS;
+	if (psm_set_single(NETWORK_MOD_NAME, VAR_DEV_SECKEY, key) !=
+	    WM_SUCCESS)
+		return -WM_FAIL;
+	lan.key_changed = true;
+	return WM_SUCCESS;
+}
+
+static void lan_tag(const uint8_t *pkt, int len, uint8_t *tag)
+{
+	uint8_t mac[32];
+
+	hmac_sha256((const uint8_t *)lan.key, lan.key_len, pkt, len, mac);
+	memcpy(tag, mac, LAN_TAG_LEN);
+}
+
+/* Constant time, not to tell how much of a forged tag was right */
+static bool lan_tag_ok(const uint8_t *pkt, int len)
+{
+	uint8_t tag[LAN_TAG_LEN], diff = 0;
+	int i;
+
+	lan_tag(pkt, len - LAN_TAG_LEN, tag);
+	for (i = 0; i < LAN_TAG_LEN; i++)
+		diff |= tag[i] ^ pkt[len - LAN_TAG_LEN + i];
+	return !diff;
+}
+
+/* Append the properties in mask as { id, value } to tx_buf at len,
+ * clearing their dirty bit for channel ch. Those that do not fit stay
+ * dirty. Returns the new length.
+ */
+static int lan_put_props(int len, unsigned mask, unsigned ch)
+{
+	struct prop_val vals[PROP_COUNT];
+	unsigned put = 0;
+	int id, n;
+
+	mask = wm_demo_props_snapshot(mask, ch, vals);
+	for (id = 0; id < PROP_COUNT; id++) {
+		if (!(mask & PROP_MASK(id)))
+			continue;
+		if (wm_demo_prop_type(id) == PROP_TYPE_STR) {
+			n = vals[id].s ? strlen(vals[id].s) : 0;
+			if (n > 255 ||
+			    len + 2 + n > LAN_PKT_LEN - LAN_TAG_LEN)
+				break;
+			tx_buf[len++] = id;
+			tx_buf[len++] = n;
+			memcpy(tx_buf + len, vals[id].s, n);
+			len += n;
+		} else {
+			if (len + 5 > LAN_PKT_LEN - LAN_TAG_LEN)
+				break;
+			tx_buf[len++] = id;
+			put_be32(tx_buf + len, vals[id].i);
+			len += 4;
+		}
+		put |= PROP_MASK(id);
+	}
+	if (ch && (mask & ~put))
+		wm_demo_props_mark_dirty(mask & ~put, ch);
+	return len;
+}
+
+/* Parse the { id, value } at the start of p into id and val, using s for
+ * a string value. Returns its length, or -WM_E_INVAL if malformed.
+ */
+static int lan_get_prop(const uint8_t *p, int len, int *id,
+			struct prop_val *val, char *s)
+{
+	int n;
+
+	*id = p[0];
+	if (*id >= PROP_COUNT)
+		return -WM_E_INVAL;
+	memset(val, 0, sizeof(*val));
+	if (wm_demo_prop_type(*id) == PROP_TYPE_STR) {
+		if (len < 2 || len < 2 + p[1] || p[1] > PROP_STR_MAXLEN)
+			return -WM_E_INVAL;
+		n = p[1];
+		memcpy(s, p + 2, n);
+		s[n] = 0;
+		val->s = s;
+		return n + 2;
+	}
+	if (len < 5)
+		return -WM_E_INVAL;
+	val->i = (int32_t)get_be32(p + 1);
+	if (wm_demo_prop_type(*id) == PROP_TYPE_BOOL &&
+	    val->i != 0 && val->i != 1)
+		return -WM_E_INVAL;
+	return 5;
+}
+
+/* Apply the { id, value } list in p. Returns the mask of the properties
+ * set, or -WM_E_INVAL if the list is malformed, in which case nothing is
+ * set.
+ */
+static int lan_set_props(const uint8_t *p, int len)
+{
+	char s[PROP_STR_MAXLEN + 1];
+	struct prop_val val;
+	unsigned mask = 0;
+	int off, id, n;
+
+	for (off = 0; off < len; off += n) {
+		n = lan_get_prop(p + off, len - off, &id, &val, s);
+		if (n < 0)
+			return n;
+	}
+
+	for (off = 0; off < len; off += n) {
+		n = lan_get_prop(p + off, len - off, &id, &val, s);
+		if (wm_demo_prop_set(id, &val) == WM_SUCCESS)
+			mask |= PROP_MASK(id);
+	}
+	return mask;
+}
+
+static void lan_send(struct lan_peer *peer, uint8_t op, int len)
+{
+	tx_buf[0] = 'W';
+	tx_buf[1] = 'L';
+	tx_buf[2] = LAN_VERSION;
+	tx_buf[3] = op;
+	put_be32(tx_buf + 4, peer->session);
+	put_be32(tx_buf + 8, ++peer->tx_seq);
+	lan_tag(tx_buf, len, tx_buf + len);
+	len += LAN_TAG_LEN;
+
+	if (sendto(lan.sock, tx_buf, len, 0, (struct sockaddr *)&peer->addr,
+		   sizeof(peer->addr)) == len)
+		lan.st.tx++;
+}
+
+static struct lan_peer *lan_peer_find(const struct sockaddr_in *addr)
+{
+	int i;
+
+	for (i = 0; i < LAN_MAX_PEERS; i++)
+		if (lan.peer[i].addr.sin_port == addr->sin_port &&
+		    lan.peer[i].addr.sin_addr.s_addr == addr->sin_addr.s_addr)
+			return &lan.peer[i];
+	return NULL;
+}
+
+/* A new session for addr, in place of the least recently seen one */
+static struct lan_peer *lan_peer_new(const struct sockaddr_in *addr)
+{
+	struct lan_peer *peer = lan_peer_find(addr);
+	unsigned long now = os_ticks_get();
+	int i;
+
+	if (!peer) {
+		peer = &lan.peer[0];
+		for (i = 1; i < LAN_MAX_PEERS; i++)
+			if (!lan.peer[i].addr.sin_port ||
+			    now - lan.peer[i].seen > now - peer->seen)
+				peer = &lan.peer[i];
+	}
+
+	memset(peer, 0, sizeof(*peer));
+	peer->addr = *addr;
+	get_random_sequence(&peer->session, sizeof(peer->session));
+	return peer;
+}
+
+static int lan_hello(int len)
+{
+	const char *name;
+	int id, n;
+
+	tx_buf[len++] = PROP_COUNT;
+	for (id = 0; id < PROP_COUNT; id++) {
+		name = wm_demo_prop_name(id);
+		n = strlen(name);
+		if (len + 2 + n > LAN_PKT_LEN - LAN_TAG_LEN)
+			break;
+		tx_buf[len++] = wm_demo_prop_type(id);
+		tx_buf[len++] = n;
+		memcpy(tx_buf + len, name, n);
+		len += n;
+	}
+	return len;
+}
+
+/* Refuse a request, handing out the nonce for the next HELLO. The answer
+ * goes out in a throw-away session.
+ */
+static void lan_refuse(const struct sockaddr_in *addr, uint8_t op)
+{
+	struct lan_peer tmp;
+
+	memset(&tmp, 0, sizeof(tmp));
+	tmp.addr = *addr;
+	tx_buf[LAN_HDR_LEN] = LAN_E_SESSION;
+	put_be32(tx_buf + LAN_HDR_LEN + 1, lan.nonce);
+	lan_send(&tmp, op | LAN_OP_RESP, LAN_HDR_LEN + 5);
+}
+
+static void lan_request(const struct sockaddr_in *addr, int len)
+{
+	uint8_t op = rx_buf[3];
+	const uint8_t *payload = rx_buf + LAN_HDR_LEN;
+	int plen = len - LAN_HDR_LEN - LAN_TAG_LEN;
+	uint32_t seq = get_be32(rx_buf + 8);
+	struct lan_peer *peer;
+	int out = LAN_HDR_LEN + 1;
+	int mask;
+
+	if (op == LAN_OP_HELLO) {
+		/* Only a HELLO carrying the current nonce may take a slot, a
+		 * recorded one cannot evict anybody
+		 */
+		if (plen != 4 || get_be32(payload) != lan.nonce) {
+			lan.st.no_session++;
+			lan_refuse(addr, op);
+			return;
+		}
+		get_random_sequence(&lan.nonce, sizeof(lan.nonce));
+		peer = lan_peer_new(addr);
+		peer->rx_seq = seq;
+		peer->seen = os_ticks_get();
+		tx_buf[LAN_HDR_LEN] = LAN_OK;
+		lan_send(peer, op | LAN_OP_RESP, lan_hello(out));
+		return;
+	}
+
+	peer = lan_peer_find(addr);
+	if (!peer || peer->session != get_be32(rx_buf + 4)) {
+		lan.st.no_session++;
+		lan_refuse(addr, op);
+		return;
+	}
+	if (seq <= peer->rx_seq) {
+		lan.st.replayed++;
+		return;
+	}
+	peer->rx_seq = seq;
+	peer->seen = os_ticks_get();
+
+	tx_buf[LAN_HDR_LEN] = LAN_OK;
+	switch (op) {
+	case LAN_OP_GET:
+		if (plen != 4)
+			goto inval;
+		out = lan_put_props(out, get_be32(payload), 0);
+		break;
+	case LAN_OP_SET:
+		mask = lan_set_props(payload, plen);
+		if (mask < 0)
+			goto inval;
+		out = lan_put_props(out, mask, 0);
+		break;
+	case LAN_OP_SUBSCRIBE:
+		peer->subscribed = true;
+		peer->sub_until = peer->seen +
+			os_msec_to_ticks(LAN_SUB_TTL_MS);
+		out = lan_put_props(out, PROP_MASK_ALL, 0);
+		break;
+	default:
+		goto inval;
+	}
+	lan_send(peer, op | LAN_OP_RESP, out);
+	return;
+
+inval:
+	tx_buf[LAN_HDR_LEN] = LAN_E_INVAL;
+	lan_send(peer, op | LAN_OP_RESP, LAN_HDR_LEN + 1);
+}
+
+static void lan_recv(void)
+{
+	struct sockaddr_in addr;
+	socklen_t alen = sizeof(addr);
+	int len;
+
+	len = recvfrom(lan.sock, rx_buf, sizeof(rx_buf), 0,
+		       (struct sockaddr *)&addr, &alen);
+	if (len < LAN_HDR_LEN + LAN_TAG_LEN)
+		return;
+	lan.st.rx++;
+
+	if (lan.key_changed)
+		lan_load_key();
+	if (!lan.key_len || rx_buf[0] != 'W' || rx_buf[1] != 'L' ||
+	    rx_buf[2] != LAN_VERSION || (rx_buf[3] & LAN_OP_RESP))
+		return;
+	if (!lan_tag_ok(rx_buf, len)) {
+		lan.st.bad_tag++;
+		return;
+	}
+	lan_request(&addr, len);
+}
+
+static void lan_notify_work(void *arg);
+
+/* Have the changes sent. May run in any thread, never blocks. */
+static void lan_kick(void)
+{
+	unsigned long flags;
+	bool queued;
+
+	if (lan.sock < 0)
+		return;
+
+	flags = os_enter_critical_section();
+	queued = lan.notify_queued;
+	lan.notify_queued = true;
+	os_exit_critical_section(flags);
+	if (!queued && wm_demo_wq_post(WQ_PRIO_LOW, lan_notify_work, NULL)
+	    != WM_SUCCESS)
+		lan.notify_queued = false;
+}
+
+/* Send pending property changes to the subscribers. Returns true if some
+ * did not fit and are still pending.
+ */
+static bool lan_notify(void)
+{
+	unsigned long now = os_ticks_get();
+	unsigned mask = wm_demo_props_dirty(PROP_CH_LAN);
+	int i, len = 0;
+
+	if (!mask)
+		return false;
+
+	for (i = 0; i < LAN_MAX_PEERS; i++) {
+		struct lan_peer *peer = &lan.peer[i];
+
+		if (!peer->subscribed)
+			continue;
+		if ((long)(now - peer->sub_until) >= 0) {
+			peer->subscribed = false;
+			continue;
+		}
+		/* Encoded once, the header is redone for each peer */
+		if (!len)
+			len = lan_put_props(LAN_HDR_LEN, mask, PROP_CH_LAN);
+		lan_send(peer, LAN_OP_NOTIFY, len);
+		lan.st.notified++;
+	}
+
+	/* Nobody to tell: what changed meanwhile is in the first answer */
+	if (!len) {
+		wm_demo_props_clear_dirty(mask, PROP_CH_LAN);
+		return false;
+	}
+	return len > LAN_HDR_LEN && (wm_demo_props_dirty(PROP_CH_LAN) & mask);
+}
+
+static void lan_notify_work(void *arg)
+{
+	bool more;
+
+	os_mutex_get(&lan.mutex, OS_WAIT_FOREVER);
+	lan.notify_queued = false;
+	more = lan_notify();
+	os_mutex_put(&lan.mutex);
+
+	/* The rest goes in the next datagram */
+	if (more)
+		lan_kick();
+}
+
+static void lan_main(os_thread_arg_t arg)
+{
+	fd_set rfds;
+	static struct wake_point wp = {"lan"};
+	int ret;
+
+	os_mutex_get(&lan.mutex, OS_WAIT_FOREVER);
+	lan_load_key();
+	os_mutex_put(&lan.mutex);
+	while (1) {
+		FD_ZERO(&rfds);
+		FD_SET(lan.sock, &rfds);
+
+		/* Changes are sent from the work queue: sleep until a
+		 * request comes
+		 */
+		ret = net_select(lan.sock + 1, &rfds, NULL, NULL, NULL);
+		if (ret > 0) {
+			os_mutex_get(&lan.mutex, OS_WAIT_FOREVER);
+			lan_recv();
+			os_mutex_put(&lan.mutex);
+		}
+		wake_audit(&wp, WAKE_MSG, ret > 0);
+	}
+}
+
+static void lan_stats_cmd(int argc, char **argv)
+{
+	unsigned long now = os_ticks_get();
+	int i;
+
+	wmprintf("port %d, key %s\r\n", LAN_PORT,
+		 lan.key_len ? "set" : "none");
+	wmprintf("rx %u tx %u bad-tag %u replayed %u no-session %u "
+		 "notified %u\r\n", lan.st.rx, lan.st.tx, lan.st.bad_tag,
+		 lan.st.replayed, lan.st.no_session, lan.st.notified);
+	for (i = 0; i < LAN_MAX_PEERS; i++) {
+		struct lan_peer *peer = &lan.peer[i];
+
+		if (!peer->addr.sin_port)
+			continue;
+		wmprintf("%s:%d seen %lu ms ago%s\r\n",
+			 inet_ntoa(peer->addr.sin_addr),
+			 ntohs(peer->addr.sin_port),
+			 os_ticks_to_msec(now - peer->seen),
+			 peer->subscribed ? ", subscribed" : "");
+	}
+}
+
+static struct cli_command lan_cmds[] = {
+	{"lan-stats", NULL, lan_stats_cmd},
+};
+
+int wm_demo_lan_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(lan_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&lan_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+int wm_demo_lan_init(void)
+{
+	struct sockaddr_in addr;
+	int ret;
+
+	if (lan.sock >= 0)
+		return WM_SUCCESS;
+
+	ret = os_mutex_create(&lan.mutex, "lan", OS_MUTEX_INHERIT);
+	if (ret != WM_SUCCESS)
+		return ret;
+	get_random_sequence(&lan.nonce, sizeof(lan.nonce));
+
+	lan.sock = net_socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (lan.sock < 0) {
+		dbg("lan: socket failed");
+		return -WM_FAIL;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(LAN_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (net_bind(lan.sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		dbg("lan: cannot bind port %d", LAN_PORT);
+		goto fail;
+	}
+
+	ret = os_thread_create(&lan_thread, "lan", lan_main, 0, &lan_stack,
+			       OS_PRIO_3);
+	if (ret != WM_SUCCESS) {
+		dbg("lan: thread creation failed: %d", ret);
+		goto fail;
+	}
+	if (wm_demo_props_add_notify(lan_kick) != WM_SUCCESS)
+		dbg("lan: no room for the property change callback");
+	return WM_SUCCESS;
+
+fail:
+	net_close(lan.sock);
+	lan.sock = -1;
+	return -WM_FAIL;
+}
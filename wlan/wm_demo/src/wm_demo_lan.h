@@ -0,0 +1,93 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Local control over UDP
+ *
+ * A compact binary protocol on LAN_PORT to get and set the device
+ * properties and to be notified of their changes, with one datagram each
+ * way per operation. Local automations keep working without the cloud and
+ * without the TCP and HTTP overhead of POST /hello. The port is announced
+ * in the mDNS TXT record as "lan=<port>".
+ *
+ * Every datagram, in network byte order:
+ *
+ *	 0  'W' 'L'	magic
+ *	 2  version	LAN_VERSION
+ *	 3  op		LAN_OP_*, with LAN_OP_RESP set in responses
+ *	 4  session	4 bytes, given by the device in the HELLO response
+ *	 8  seq		4 bytes, increasing for each datagram of a sender
+ *	12  payload
+ *	 n  tag		first LAN_TAG_LEN bytes of HMAC-SHA256(key, bytes 0..n-1)
+ *
+ * The key is the device key posted to /hello as "secKey" while the device
+ * was being provisioned, or the provisioning key (network.prov_key) if
+ * there is none. Without a key,
+ * nothing is answered. Datagrams with a wrong tag are dropped silently.
+ *
+ * A client first sends HELLO (any session) with the device nonce. The
+ * device sets up a session for the client address and port, answers with
+ * it and picks a new nonce, so that a recorded HELLO cannot take the slot
+ * of another client. Other requests must carry that session and a
+ * sequence number above the previous one, so recorded datagrams cannot be
+ * played again. A client whose session or nonce is unknown (e.g. after a
+ * reboot) gets LAN_E_SESSION with the current nonce and says HELLO again.
+ *
+ * Payloads:
+ *
+ *	HELLO nonce(4)	-> status, count, count x { type, name len, name }
+ *	any		-> LAN_E_SESSION, nonce(4) if refused
+ *	GET mask(4)	-> status, props
+ *	SET props	-> status, props (the ones that were set)
+ *	SUBSCRIBE	-> status, props (all of them)
+ *	NOTIFY props	   sent by the device to subscribers, not answered
+ *
+ * where props is a list of { id, value }: id is the property index in the
+ * HELLO list and the value a 4 byte integer, or a length byte and the
+ * bytes of a string. A subscription lasts LAN_SUB_TTL_MS and is renewed
+ * by subscribing again.
+ */
+
+#ifndef _WM_DEMO_LAN_H_
+#define _WM_DEMO_LAN_H_
+
+#include <wmtypes.h>
+
+#define LAN_PORT		8082
+#define LAN_VERSION		2
+#define LAN_MAX_PEERS		4
+#define LAN_SUB_TTL_MS		60000
+#define LAN_TAG_LEN		8
+#define LAN_HDR_LEN		12
+#define LAN_PKT_LEN		256
+
+#define LAN_OP_HELLO		1
+#define LAN_OP_GET		2
+#define LAN_OP_SET		3
+#define LAN_OP_SUBSCRIBE	4
+#define LAN_OP_NOTIFY		5
+#define LAN_OP_RESP		0x80
+
+#define LAN_OK			0
+#define LAN_E_SESSION		1
+#define LAN_E_INVAL		2
+
+/** Start the server. Needs the network stack: call once the WLAN is
+ * initialized.
+ */
+int wm_demo_lan_init(void);
+
+/** Use key from now on and keep it in the PSM. Existing sessions end.
+ * Returns -WM_E_PERM unless the key is open, see wm_demo_lan_open_key().
+ */
+int wm_demo_lan_set_key(const char *key);
+
+/** Let wm_demo_lan_set_key() replace the key or not. It is sent without
+ * authentication: only open it while the device is being provisioned.
+ */
+void wm_demo_lan_open_key(bool open);
+
+int wm_demo_lan_cli_init(void);
+
+#endif /* _WM_DEMO_LAN_H_ */
@@ -0,0 +1,596 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <wlan.h>
+#include <appln_dbg.h>
+#include <wmcloud.h>
+#include <wm_demo_props.h>
+#include <wm_demo_msg.h>
+
+/* Property masks are plain unsigned bitmaps */
+WM_DEMO_MSG_BUILD_ASSERT(PROP_COUNT <= 32);
+/* A command of maximal size must fit in the device channel read buffer */
+WM_DEMO_MSG_BUILD_ASSERT(WM_DEMO_MSG_CMD_BUFSZ <= WM_DEMO_MSG_RX_BUFSZ);
+
+/* Limits the recursion of the decoder on hostile input */
+#define MSG_MAX_DEPTH		8
+
+/*------------------------- Property keys ------------------------------*/
+
+/* "name": keys are generated once so that encoding a property is a
+ * single memcpy.
+ */
+struct msg_prop_key {
+	const char *key;
+	uint8_t len;
+	prop_type_t type;
+};
+
+#define MSG_PROP_KEY(_name, _type, _get, _set)				\
+	{ "\"" #_name "\":", sizeof("\"" #_name "\":") - 1, _type },
+static const struct msg_prop_key prop_keys[PROP_COUNT] = {
+	WM_DEMO_PROPS(MSG_PROP_KEY)
+};
+#undef MSG_PROP_KEY
+
+static int msg_prop_find(const char *key, int len)
+{
+	int id;
+
+	/* Stored keys are quoted and followed by ':' */
+	for (id = 0; id < PROP_COUNT; id++)
+		if (prop_keys[id].len == len + 3 &&
+		    !memcmp(prop_keys[id].key + 1, key, len))
+			return id;
+	return -1;
+}
+
+/*------------------------- Encoder ------------------------------------*/
+
+/* The output buffer is sized at compile time for the worst case of the
+ * message being encoded, so none of these need bound checks.
+ */
+static inline char *msg_put(char *p, const char *s, int len)
+{
+	memcpy(p, s, len);
+	return p + len;
+}
+
+#define msg_put_lit(_p, _lit)	msg_put(_p, _lit, sizeof(_lit) - 1)
+
+static char *msg_put_int(char *p, int val)
+{
+	char tmp[MSG_INT_MAXLEN];
+	unsigned u = val;
+	int n = 0;
+
+	if (val < 0) {
+		*p++ = '-';
+		u = -u;
+	}
+	do {
+		tmp[n++] = '0' + u % 10;
+		u /= 10;
+	} while (u);
+	while (n)
+		*p++ = tmp[--n];
+	return p;
+}
+
+/* Quoted string, truncated to maxlen input characters. Every character
+ * expands to at most two, which is what WM_DEMO_MSG_MAXLEN() accounts for.
+ */
+static char *msg_put_str(char *p, const char *s, int maxlen)
+{
+	*p++ = '"';
+	for (; s && *s && maxlen; s++, maxlen--) {
+		char c = *s;
+
+		switch (c) {
+		case '"':
+		case '\\':
+			*p++ = '\\';
+			*p++ = c;
+			break;
+		case '\n':
+			p = msg_put_lit(p, "\\n");
+			break;
+		case '\r':
+			p = msg_put_lit(p, "\\r");
+			break;
+		case '\t':
+			p = msg_put_lit(p, "\\t");
+			break;
+		default:
+			/* Other control characters are dropped */
+			if ((unsigned char)c >= 0x20)
+				*p++ = c;
+			break;
+		}
+	}
+	*p++ = '"';
+	return p;
+}
+
+static char *msg_put_props(char *p, unsigned mask,
+			   const struct prop_val *vals)
+{
+	int id;
+
+	for (id = 0; id < PROP_COUNT; id++) {
+		if (!(mask & PROP_MASK(id)))
+			continue;
+
+		p = msg_put(p, prop_keys[id].key, prop_keys[id].len);
+		switch (prop_keys[id].type) {
+		case PROP_TYPE_BOOL:
+			*p++ = vals[id].i ? '1' : '0';
+			break;
+		case PROP_TYPE_INT:
+			p = msg_put_int(p, vals[id].i);
+			break;
+		case PROP_TYPE_STR:
+			p = msg_put_str(p, vals[id].s, PROP_STR_MAXLEN);
+			break;
+		}
+		*p++ = ',';
+	}
+	return p;
+}
+
+#define MSG_ENC_CONST(_k, _v)						\
+	p = msg_put_lit(p, "\"" #_k "\":\"" _v "\",");
+#define MSG_ENC_STR(_k, _n)						\
+	if (m->has_##_k) {						\
+		p = msg_put_lit(p, "\"" #_k "\":");			\
+		p = msg_put_str(p, m->_k, _n);				\
+		*p++ = ',';						\
+	}
+#define MSG_ENC_INT(_k)							\
+	if (m->has_##_k) {						\
+		p = msg_put_lit(p, "\"" #_k "\":");			\
+		p = msg_put_int(p, m->_k);				\
+		*p++ = ',';						\
+	}
+#define MSG_ENC_PL(_k)							\
+	if (m->_k##_mask) {						\
+		p = msg_put_lit(p, "\"" #_k "\":{\"pl\":[{");		\
+		p = msg_put_props(p, m->_k##_mask, m->_k);		\
+		p = msg_put_lit(p, "\"pid\":0}]},");			\
+	}
+
+/* Returns the encoded length, EOL included, not counting the NUL */
+#define MSG_DEFINE_ENCODER(_name, _LIST)				\
+int wm_demo_msg_##_name##_encode(const struct wm_demo_msg_##_name *m,	\
+				 char (*buf)[WM_DEMO_MSG_BUFSZ(_LIST)])	\
+{									\
+	char *p = *buf;							\
+									\
+	*p++ = '{';							\
+	_LIST(MSG_ENC_CONST, MSG_ENC_STR, MSG_ENC_INT, MSG_ENC_PL)	\
+	if (p[-1] == ',')						\
+		p--;							\
+	*p++ = '}';							\
+	p = msg_put_lit(p, WM_DEMO_MSG_EOL);				\
+	*p = 0;								\
+	return p - *buf;						\
+}
+
+/*------------------------- Decoder ------------------------------------*/
+
+enum msg_tok_type {
+	MSG_TOK_STR,
+	MSG_TOK_NUM,
+	MSG_TOK_BOOL,
+	MSG_TOK_NULL,
+	MSG_TOK_OBJ,
+	MSG_TOK_ARR,
+};
+
+struct msg_tok {
+	enum msg_tok_type type;
+	const char *s;		/* MSG_TOK_STR, NUL terminated in place */
+	int len;
+	int i;			/* MSG_TOK_NUM, MSG_TOK_BOOL */
+};
+
+/* Destination of the property payload of the message being decoded */
+struct msg_pl {
+	unsigned *mask;
+	unsigned *query;
+	struct prop_val *vals;
+};
+
+typedef void (*msg_field_fn_t)(void *m, const char *key, int klen,
+			       const struct msg_tok *t);
+
+struct msg_parser {
+	char *p;
+	char *end;
+	msg_field_fn_t field;
+	void *m;
+	struct msg_pl pl;
+};
+
+static int msg_parse_value(struct msg_parser *ps, int depth,
+			   struct msg_tok *t);
+
+static inline void msg_skip_ws(struct msg_parser *ps)
+{
+	while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' ||
+				   *ps->p == '\r' || *ps->p == '\n'))
+		ps->p++;
+}
+
+static inline int msg_peek(struct msg_parser *ps)
+{
+	msg_skip_ws(ps);
+	return ps->p < ps->end ? *ps->p : -1;
+}
+
+static int msg_hex(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+/* Unescape a string in place. The result is never longer than the source,
+ * so the terminating NUL always lands at or before the closing quote.
+ */
+static int msg_parse_string(struct msg_parser *ps, struct msg_tok *t)
+{
+	char *w = ++ps->p;
+
+	t->type = MSG_TOK_STR;
+	t->s = w;
+	while (ps->p < ps->end) {
+		char c = *ps->p++;
+
+		if (c == '"') {
+			*w = 0;
+			t->len = w - t->s;
+			return WM_SUCCESS;
+		}
+		if (c != '\\') {
+			*w++ = c;
+			continue;
+		}
+		if (ps->p >= ps->end)
+			break;
+		switch (c = *ps->p++) {
+		case 'b': *w++ = '\b'; break;
+		case 'f': *w++ = '\f'; break;
+		case 'n': *w++ = '\n'; break;
+		case 'r': *w++ = '\r'; break;
+		case 't': *w++ = '\t'; break;
+		case 'u': {
+			int k, u = 0;
+
+			if (ps->end - ps->p < 4)
+				return -WM_E_INVAL;
+			for (k = 0; k < 4; k++) {
+				int h = msg_hex(*ps->p++);
+				if (h < 0)
+					return -WM_E_INVAL;
+				u = (u << 4) | h;
+			}
+			/* Only ASCII is meaningful to the application */
+			*w++ = u < 0x80 ? u : '?';
+			break;
+		}
+		default:
+			*w++ = c;
+			break;
+		}
+	}
+	return -WM_E_INVAL;
+}
+
+static int msg_parse_number(struct msg_parser *ps, struct msg_tok *t)
+{
+	bool neg = false;
+	unsigned u = 0;
+
+	if (*ps->p == '-') {
+		neg = true;
+		ps->p++;
+	}
+	if (ps->p >= ps->end || *ps->p < '0' || *ps->p > '9')
+		return -WM_E_INVAL;
+	while (ps->p < ps->end && *ps->p >= '0' && *ps->p <= '9')
+		u = u * 10 + (*ps->p++ - '0');
+	/* Fractions and exponents are accepted but ignored */
+	while (ps->p < ps->end && (*ps->p == '.' || *ps->p == 'e' ||
+				   *ps->p == 'E' || *ps->p == '+' ||
+				   *ps->p == '-' ||
+				   (*ps->p >= '0' && *ps->p <= '9')))
+		ps->p++;
+
+	t->type = MSG_TOK_NUM;
+	t->i = neg ? -(int)u : (int)u;
+	return WM_SUCCESS;
+}
+
+static int msg_parse_literal(struct msg_parser *ps, const char *lit, int len)
+{
+	if (ps->end - ps->p < len || memcmp(ps->p, lit, len))
+		return -WM_E_INVAL;
+	ps->p += len;
+	return WM_SUCCESS;
+}
+
+/* One element of the "pl" array: {"name":value,...,"pid":0} */
+static void msg_pl_prop(struct msg_parser *ps, const char *key, int klen,
+			const struct msg_tok *t)
+{
+	struct prop_val *val;
+	int id = msg_prop_find(key, klen);
+
+	if (id < 0 || !ps->pl.vals)
+		return;
+
+	if (t->type == MSG_TOK_STR && !strcmp(t->s, QUERY_STR)) {
+		*ps->pl.query |= PROP_MASK(id);
+		return;
+	}
+
+	val = &ps->pl.vals[id];
+	switch (prop_keys[id].type) {
+	case PROP_TYPE_BOOL:
+		if ((t->type != MSG_TOK_NUM && t->type != MSG_TOK_BOOL) ||
+		    (t->i != 0 && t->i != 1))
+			return;
+		val->i = t->i;
+		break;
+	case PROP_TYPE_INT:
+		if (t->type != MSG_TOK_NUM)
+			return;
+		val->i = t->i;
+		break;
+	case PROP_TYPE_STR:
+		if (t->type != MSG_TOK_STR || t->len > PROP_STR_MAXLEN)
+			return;
+		val->s = t->s;
+		break;
+	}
+	*ps->pl.mask |= PROP_MASK(id);
+}
+
+static int msg_parse_object(struct msg_parser *ps, int depth, bool pl_item)
+{
+	struct msg_tok key, val;
+	int ret;
+
+	if (depth > MSG_MAX_DEPTH)
+		return -WM_E_INVAL;
+
+	ps->p++;
+	if (msg_peek(ps) == '}') {
+		ps->p++;
+		return WM_SUCCESS;
+	}
+
+	while (1) {
+		if (msg_peek(ps) != '"')
+			return -WM_E_INVAL;
+		ret = msg_parse_string(ps, &key);
+		if (ret != WM_SUCCESS)
+			return ret;
+		if (msg_peek(ps) != ':')
+			return -WM_E_INVAL;
+		ps->p++;
+
+		/* Elements of a "pl" array hold properties, at any depth */
+		if (key.len == 2 && !memcmp(key.s, "pl", 2) &&
+		    msg_peek(ps) == '[') {
+			ret = msg_parse_value(ps, -(depth + 1), &val);
+		} else {
+			ret = msg_parse_value(ps, depth + 1, &val);
+		}
+		if (ret != WM_SUCCESS)
+			return ret;
+
+		if (pl_item)
+			msg_pl_prop(ps, key.s, key.len, &val);
+		else if (depth == 1)
+			ps->field(ps->m, key.s, key.len, &val);
+
+		switch (msg_peek(ps)) {
+		case ',':
+			ps->p++;
+			break;
+		case '}':
+			ps->p++;
+			return WM_SUCCESS;
+		default:
+			return -WM_E_INVAL;
+		}
+	}
+}
+
+/* A negative depth marks the "pl" array, whose objects carry properties */
+static int msg_parse_array(struct msg_parser *ps, int depth)
+{
+	bool pl = depth < 0;
+	struct msg_tok val;
+	int ret;
+
+	if (pl)
+		depth = -depth;
+	if (depth > MSG_MAX_DEPTH)
+		return -WM_E_INVAL;
+
+	ps->p++;
+	if (msg_peek(ps) == ']') {
+		ps->p++;
+		return WM_SUCCESS;
+	}
+
+	while (1) {
+		if (pl && msg_peek(ps) == '{')
+			ret = msg_parse_object(ps, depth + 1, true);
+		else
+			ret = msg_parse_value(ps, depth + 1, &val);
+		if (ret != WM_SUCCESS)
+			return ret;
+
+		switch (msg_peek(ps)) {
+		case ',':
+			ps->p++;
+			break;
+		case ']':
+			ps->p++;
+			return WM_SUCCESS;
+		default:
+			return -WM_E_INVAL;
+		}
+	}
+}
+
+static int msg_parse_value(struct msg_parser *ps, int depth,
+			   struct msg_tok *t)
+{
+	memset(t, 0, sizeof(*t));
+
+	switch (msg_peek(ps)) {
+	case '{':
+		t->type = MSG_TOK_OBJ;
+		return msg_parse_object(ps, depth, false);
+	case '[':
+		t->type = MSG_TOK_ARR;
+		return msg_parse_array(ps, depth);
+	case '"':
+		return msg_parse_string(ps, t);
+	case 't':
+		t->type = MSG_TOK_BOOL;
+		t->i = 1;
+		return msg_parse_literal(ps, "true", 4);
+	case 'f':
+		t->type = MSG_TOK_BOOL;
+		return msg_parse_literal(ps, "false", 5);
+	case 'n':
+		t->type = MSG_TOK_NULL;
+		return msg_parse_literal(ps, "null", 4);
+	case -1:
+		return -WM_E_INVAL;
+	default:
+		return msg_parse_number(ps, t);
+	}
+}
+
+static int msg_parse(char *buf, int len, msg_field_fn_t field, void *m,
+		     const struct msg_pl *pl)
+{
+	struct msg_parser ps = {
+		.p = buf,
+		.end = buf + len,
+		.field = field,
+		.m = m,
+		.pl = *pl,
+	};
+
+	if (msg_peek(&ps) != '{')
+		return -WM_E_INVAL;
+	return msg_parse_object(&ps, 1, false);
+}
+
+#define MSG_KEY_IS(_lit)						\
+	(klen == sizeof(_lit) - 1 && !memcmp(key, _lit, klen))
+
+#define MSG_DEC_CONST(_k, _v)						\
+	if (MSG_KEY_IS(#_k)) {						\
+		if (t->type == MSG_TOK_STR &&				\
+		    t->len == sizeof(_v) - 1 && !memcmp(t->s, _v, t->len)) \
+			m->has_##_k = true;				\
+		return;							\
+	}
+#define MSG_DEC_STR(_k, _n)						\
+	if (MSG_KEY_IS(#_k)) {						\
+		if (t->type == MSG_TOK_STR && t->len <= (_n)) {		\
+			m->_k = t->s;					\
+			m->has_##_k = true;				\
+		}							\
+		return;							\
+	}
+#define MSG_DEC_INT(_k)							\
+	if (MSG_KEY_IS(#_k)) {						\
+		if (t->type == MSG_TOK_NUM) {				\
+			m->_k = t->i;					\
+			m->has_##_k = true;				\
+		}							\
+		return;							\
+	}
+/* The payload is filled by the parser itself through struct msg_pl */
+#define MSG_DEC_PL(_k)
+
+#define MSG_PL_NONE(...)
+#define MSG_PL_BIND(_k)							\
+	pl.mask = &m->_k##_mask;					\
+	pl.query = &m->_k##_query;					\
+	pl.vals = m->_k;
+
+/* Strings in the decoded message point into buf, which is modified */
+#define MSG_DEFINE_DECODER(_name, _LIST)				\
+static void msg_##_name##_field(void *arg, const char *key, int klen,	\
+				const struct msg_tok *t)		\
+{									\
+	struct wm_demo_msg_##_name *m = arg;				\
+									\
+	_LIST(MSG_DEC_CONST, MSG_DEC_STR, MSG_DEC_INT, MSG_DEC_PL)	\
+}									\
+									\
+int wm_demo_msg_##_name##_decode(char *buf, int len,			\
+				 struct wm_demo_msg_##_name *m)		\
+{									\
+	struct msg_pl pl;						\
+									\
+	memset(m, 0, sizeof(*m));					\
+	memset(&pl, 0, sizeof(pl));					\
+	_LIST(MSG_PL_NONE, MSG_PL_NONE, MSG_PL_NONE, MSG_PL_BIND)	\
+	return msg_parse(buf, len, msg_##_name##_field, m, &pl);	\
+}
+
+/*------------------------- Messages -----------------------------------*/
+
+MSG_DEFINE_ENCODER(report, WM_DEMO_MSG_REPORT)
+MSG_DEFINE_DECODER(cmd, WM_DEMO_MSG_CMD)
+
+unsigned wm_demo_msg_apply_props(unsigned mask, const struct prop_val *vals)
+{
+	unsigned set = 0;
+	int id;
+
+	for (id = 0; id < PROP_COUNT; id++) {
+		if (!(mask & PROP_MASK(id)))
+			continue;
+		if (wm_demo_prop_set(id, &vals[id]) == WM_SUCCESS) {
+			dbg("prop %s set", wm_demo_prop_name(id));
+			set |= PROP_MASK(id);
+		}
+	}
+	return set;
+}
+
+const char *wm_demo_sn_id(void)
+{
+	static char sn_id[WM_DEMO_SN_ID_LEN + 1];
+	uint8_t mac[6];
+
+	if (sn_id[0])
+		return sn_id;
+
+	/* Not before the WLAN is up: try again next time */
+	if (wlan_get_mac_address(mac) != WM_SUCCESS)
+		return "";
+	snprintf(sn_id, sizeof(sn_id), "ck00345678%02X%02X%02X%02X%02X%02X",
+		 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+	return sn_id;
+}
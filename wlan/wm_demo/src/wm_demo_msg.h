@@ -0,0 +1,133 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Device channel message codecs
+ *
+ * The messages exchanged on the device channel are described once below
+ * as X-macro lists. Each list is expanded at compile time into:
+ *
+ *   - struct wm_demo_msg_<name>     the message fields
+ *   - WM_DEMO_MSG_BUFSZ(list)       exact worst case encoded size
+ *   - wm_demo_msg_<name>_encode()   specialized encoder (outbound)
+ *   - wm_demo_msg_<name>_decode()   single pass, in-place decoder (inbound)
+ *
+ * Field kinds:
+ *
+ *   CONST(key, "value")  constant string (encoded as is, checked on decode)
+ *   STR(key, maxlen)     string of at most maxlen characters
+ *   INT(key)             signed 32-bit integer
+ *   PL(key)              property payload: "key":{"pl":[{<props>,"pid":0}]}
+ *
+ * Encoders take a pointer to an array of exactly WM_DEMO_MSG_BUFSZ() bytes,
+ * so passing a buffer of another size is an incompatible pointer type,
+ * made an error by the Makefile, rather than an overflow at runtime.
+ * String fields are bounded by their maxlen.
+ */
+
+#ifndef _WM_DEMO_MSG_H_
+#define _WM_DEMO_MSG_H_
+
+#include <wmtypes.h>
+#include <wm_demo_props.h>
+
+/* Device serial number: "ck00345678" followed by the MAC address */
+#define WM_DEMO_SN_ID_LEN	22
+
+/* Every message on the device channel is terminated by CRLF */
+#define WM_DEMO_MSG_EOL		"\r\n"
+
+/* Report sent by the device when its state changes */
+#define WM_DEMO_MSG_REPORT(CONST, STR, INT, PL)			\
+	CONST(a, "report")					\
+	PL(d)							\
+	STR(id, WM_DEMO_SN_ID_LEN)				\
+	INT(t)
+
+/* Command or acknowledgement sent by the server. The property payload
+ * is accepted wherever the "pl" array appears in the message.
+ */
+#define WM_DEMO_MSG_CMD(CONST, STR, INT, PL)			\
+	STR(a, 16)						\
+	STR(status, 32)						\
+	STR(code, 48)						\
+	INT(t)							\
+	PL(d)
+
+/*------------------------- Generators ---------------------------------*/
+
+#define WM_DEMO_MSG_BUILD_ASSERT(_cond)					\
+	extern char wm_demo_msg_build_assert[(_cond) ? 1 : -1]
+
+#define MSG_INT_MAXLEN		11	/* "-2147483648" */
+
+#define MSG_MEMBER_CONST(_k, _v)	bool has_##_k;
+#define MSG_MEMBER_STR(_k, _n)		const char *_k; bool has_##_k;
+#define MSG_MEMBER_INT(_k)		int _k; bool has_##_k;
+#define MSG_MEMBER_PL(_k)						\
+	unsigned _k##_mask;		/* properties to encode/decoded */ \
+	unsigned _k##_query;		/* properties queried with "?" */ \
+	struct prop_val _k[PROP_COUNT];
+
+/* Each field is followed by a separator (',' or the closing '}') */
+#define MSG_LEN_CONST(_k, _v)	(sizeof("\"" #_k "\":\"" _v "\",") - 1) +
+#define MSG_LEN_STR(_k, _n)	(sizeof("\"" #_k "\":\"\",") - 1 + 2 * (_n)) +
+#define MSG_LEN_INT(_k)		(sizeof("\"" #_k "\":,") - 1 + MSG_INT_MAXLEN) +
+#define MSG_LEN_PL(_k)							\
+	(sizeof("\"" #_k "\":{\"pl\":[{\"pid\":0}]},") - 1 +		\
+	 WM_DEMO_PROPS_MAXLEN) +
+
+/** Longest possible encoding of a message (without EOL and NUL) */
+#define WM_DEMO_MSG_MAXLEN(_LIST)					\
+	(1 + _LIST(MSG_LEN_CONST, MSG_LEN_STR, MSG_LEN_INT, MSG_LEN_PL) 0)
+
+/** Buffer size needed by the encoder of a message */
+#define WM_DEMO_MSG_BUFSZ(_LIST)					\
+	(WM_DEMO_MSG_MAXLEN(_LIST) + sizeof(WM_DEMO_MSG_EOL))
+
+#define WM_DEMO_MSG_STRUCT(_name, _LIST)				\
+	struct wm_demo_msg_##_name {					\
+		_LIST(MSG_MEMBER_CONST, MSG_MEMBER_STR,			\
+		      MSG_MEMBER_INT, MSG_MEMBER_PL)			\
+	};
+
+/* Returns the encoded length, EOL included */
+#define WM_DEMO_MSG_ENCODER(_name, _LIST)				\
+	int wm_demo_msg_##_name##_encode(				\
+		const struct wm_demo_msg_##_name *m,			\
+		char (*buf)[WM_DEMO_MSG_BUFSZ(_LIST)]);
+
+/* Decodes in place: strings in m point into buf. Returns -WM_E_INVAL if
+ * buf is not a well formed JSON object.
+ */
+#define WM_DEMO_MSG_DECODER(_name, _LIST)				\
+	int wm_demo_msg_##_name##_decode(char *buf, int len,		\
+		struct wm_demo_msg_##_name *m);
+
+/*------------------------- Messages -----------------------------------*/
+
+#define WM_DEMO_MSG_REPORT_BUFSZ	WM_DEMO_MSG_BUFSZ(WM_DEMO_MSG_REPORT)
+#define WM_DEMO_MSG_CMD_BUFSZ		WM_DEMO_MSG_BUFSZ(WM_DEMO_MSG_CMD)
+
+/* Size of the buffer the device channel is read into */
+#define WM_DEMO_MSG_RX_BUFSZ		512
+
+WM_DEMO_MSG_STRUCT(report, WM_DEMO_MSG_REPORT)
+WM_DEMO_MSG_ENCODER(report, WM_DEMO_MSG_REPORT)
+
+WM_DEMO_MSG_STRUCT(cmd, WM_DEMO_MSG_CMD)
+WM_DEMO_MSG_DECODER(cmd, WM_DEMO_MSG_CMD)
+
+/** Device serial number used as "id" on the device channel and "snId"
+ * on the local interfaces. Derived from the MAC address: empty until the
+ * WLAN is initialized.
+ */
+const char *wm_demo_sn_id(void);
+
+/** Apply the properties received in a decoded payload. Returns the mask of
+ * properties that were set.
+ */
+unsigned wm_demo_msg_apply_props(unsigned mask, const struct prop_val *vals);
+
+#endif /* _WM_DEMO_MSG_H_ */
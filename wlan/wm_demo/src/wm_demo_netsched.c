@@ -0,0 +1,319 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <wlan.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <wm_demo_wq.h>
+#include <wm_demo_netsched.h>
+
+static struct {
+	struct netsched_job *jobs[NETSCHED_MAX_JOBS];
+	int njobs;
+	bool posted;			/* a batch waits on the work queue */
+	bool piggyback;			/* and it was not asked by the timer */
+	int dtim_ms;			/* 0 if not known */
+	unsigned long dtim_ref;		/* ticks, on the DTIM grid */
+	/* Stats */
+	unsigned wakeups;		/* batches started by the timer */
+	unsigned piggybacks;		/* batches started by another sender */
+	unsigned runs;
+} ns;
+
+static os_mutex_t ns_mutex;
+static os_timer_t ns_timer;
+
+static void netsched_batch(void *arg);
+
+/* Latest time in [from, to] on the DTIM grid, or to if there is none */
+static unsigned long netsched_align(unsigned long from, unsigned long to)
+{
+	unsigned long grid, t;
+
+	if (!ns.dtim_ms)
+		return to;
+	grid = os_msec_to_ticks(ns.dtim_ms);
+	t = to - (to - ns.dtim_ref) % grid;
+	return (long)(t - from) >= 0 ? t : to;
+}
+
+/* The window of a job: it may run from netsched_open() on, and must by
+ * netsched_deadline()
+ */
+static unsigned long netsched_open(const struct netsched_job *job)
+{
+	return job->late ? job->due :
+		job->due - os_msec_to_ticks(job->slack_ms);
+}
+
+static unsigned long netsched_deadline(const struct netsched_job *job)
+{
+	return job->late ? job->due + os_msec_to_ticks(job->slack_ms) :
+		job->due;
+}
+
+/* Program the timer for the next batch. Called with ns_mutex held. */
+static void netsched_arm(unsigned long now)
+{
+	struct netsched_job *first = NULL;
+	unsigned long start, t;
+	int i;
+
+	for (i = 0; i < ns.njobs; i++)
+		if (ns.jobs[i]->active &&
+		    (!first || (long)(netsched_deadline(ns.jobs[i]) -
+				      netsched_deadline(first)) < 0))
+			first = ns.jobs[i];
+	if (!first) {
+		os_timer_deactivate(&ns_timer);
+		return;
+	}
+
+	start = netsched_open(first);
+	if ((long)(start - now) < 0)
+		start = now;
+	t = netsched_align(start, netsched_deadline(first));
+	/* Never wait for the timer queue: its task may want the mutex */
+	os_timer_change(&ns_timer, (long)(t - now) > 0 ? t - now : 1, 0);
+	os_timer_activate(&ns_timer);
+}
+
+static bool netsched_window_open(struct netsched_job *job,
+				 unsigned long now)
+{
+	return job->active && (long)(now - netsched_open(job)) >= 0;
+}
+
+/* Queue a batch. Called with ns_mutex held. */
+static void netsched_post(bool piggyback)
+{
+	if (ns.posted)
+		return;
+	if (wm_demo_wq_post(WQ_PRIO_LOW, netsched_batch, NULL) != WM_SUCCESS)
+		return;
+	ns.posted = true;
+	ns.piggyback = piggyback;
+}
+
+/* Runs in the timer task, which must not wait: if the mutex is taken,
+ * try again on the next tick.
+ */
+static void netsched_timer_cb(os_timer_arg_t arg)
+{
+	if (os_mutex_get(&ns_mutex, OS_NO_WAIT) != WM_SUCCESS) {
+		os_timer_change(&ns_timer, 1, 0);
+		os_timer_activate(&ns_timer);
+		return;
+	}
+	netsched_post(false);
+	os_mutex_put(&ns_mutex);
+}
+
+static void netsched_batch(void *arg)
+{
+	struct netsched_job *run[NETSCHED_MAX_JOBS], *job;
+	unsigned long now = os_ticks_get();
+	int i, n = 0;
+
+	os_mutex_get(&ns_mutex, OS_WAIT_FOREVER);
+	ns.posted = false;
+	for (i = 0; i < ns.njobs; i++) {
+		job = ns.jobs[i];
+		if (!netsched_window_open(job, now))
+			continue;
+		run[n++] = job;
+		job->runs++;
+		if (ns.piggyback)
+			job->piggybacked++;
+		if ((long)(job->due - now) > 0)
+			job->early_ms += os_ticks_to_msec(job->due - now);
+		if (!job->period_ms) {
+			job->active = false;
+			job->active_ms += os_ticks_to_msec(now - job->since);
+			continue;
+		}
+		/* From this run: never more than a period between two */
+		job->due = now + os_msec_to_ticks(job->period_ms);
+	}
+	if (n) {
+		ns.runs += n;
+		if (ns.piggyback)
+			ns.piggybacks++;
+		else
+			ns.wakeups++;
+	}
+	netsched_arm(now);
+	os_mutex_put(&ns_mutex);
+
+	/* Back to back, while the radio is up */
+	for (i = 0; i < n; i++)
+		run[i]->fn(run[i]->arg);
+}
+
+int wm_demo_netsched_start(struct netsched_job *job, int delay_ms)
+{
+	int i;
+
+	if (job->period_ms < 0 || job->slack_ms < 0 || delay_ms < 0)
+		return -WM_E_INVAL;
+
+	os_mutex_get(&ns_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < ns.njobs; i++)
+		if (ns.jobs[i] == job)
+			break;
+	if (i == ns.njobs) {
+		if (ns.njobs == NETSCHED_MAX_JOBS) {
+			os_mutex_put(&ns_mutex);
+			return -WM_E_NOMEM;
+		}
+		ns.jobs[ns.njobs++] = job;
+	}
+	if (!job->active)
+		job->since = os_ticks_get();
+	job->due = os_ticks_get() + os_msec_to_ticks(delay_ms);
+	job->active = true;
+	netsched_arm(os_ticks_get());
+	os_mutex_put(&ns_mutex);
+	return WM_SUCCESS;
+}
+
+void wm_demo_netsched_stop(struct netsched_job *job)
+{
+	os_mutex_get(&ns_mutex, OS_WAIT_FOREVER);
+	if (job->active)
+		job->active_ms += os_ticks_to_msec(os_ticks_get() - job->since);
+	job->active = false;
+	netsched_arm(os_ticks_get());
+	os_mutex_put(&ns_mutex);
+}
+
+void wm_demo_netsched_link_up(void)
+{
+	struct wlan_network net;
+	int ms = 0;
+
+	/* Beacon period in TU of 1024 us */
+	if (wlan_get_current_network(&net) == WM_SUCCESS)
+		ms = net.beacon_period * (net.dtim_period ? net.dtim_period : 1)
+			* 1024 / 1000;
+
+	/* The TSF is not known here: the grid starts now, which still lines
+	 * all the jobs up on the same DTIM intervals.
+	 */
+	os_mutex_get(&ns_mutex, OS_WAIT_FOREVER);
+	ns.dtim_ms = ms;
+	ns.dtim_ref = os_ticks_get();
+	netsched_arm(ns.dtim_ref);
+	os_mutex_put(&ns_mutex);
+}
+
+void wm_demo_netsched_radio_busy(void)
+{
+	unsigned long now = os_ticks_get();
+	int i;
+
+	if (!ns_mutex)
+		return;
+	os_mutex_get(&ns_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < ns.njobs; i++)
+		if (netsched_window_open(ns.jobs[i], now)) {
+			netsched_post(true);
+			break;
+		}
+	os_mutex_put(&ns_mutex);
+}
+
+int wm_demo_netsched_init(void)
+{
+	int ret;
+
+	if (ns_mutex)
+		return WM_SUCCESS;
+
+	ret = os_mutex_create(&ns_mutex, "netsched", OS_MUTEX_INHERIT);
+	if (ret != WM_SUCCESS)
+		return ret;
+	ret = os_timer_create(&ns_timer, "netsched", 1, netsched_timer_cb,
+			      NULL, OS_TIMER_ONE_SHOT, OS_TIMER_NO_ACTIVATE);
+	if (ret != WM_SUCCESS)
+		os_mutex_delete(&ns_mutex);
+	return ret;
+}
+
+/* A job as shown by the netsched command */
+struct netsched_row {
+	const char *name;
+	int period_ms;
+	int slack_ms;
+	bool active;
+	unsigned runs;
+	unsigned piggybacked;
+	unsigned long early_avg;
+};
+
+static void netsched_cmd(int argc, char **argv)
+{
+	struct netsched_row row[NETSCHED_MAX_JOBS];
+	unsigned long now = os_ticks_get(), ms;
+	struct netsched_job *job;
+	unsigned alone = 0, runs, wakeups, piggybacks;
+	int i, n, dtim_ms;
+
+	/* Copied out: the timer task must not wait for the UART */
+	os_mutex_get(&ns_mutex, OS_WAIT_FOREVER);
+	dtim_ms = ns.dtim_ms;
+	n = ns.njobs;
+	for (i = 0; i < n; i++) {
+		job = ns.jobs[i];
+		row[i].name = job->name;
+		row[i].period_ms = job->period_ms;
+		row[i].slack_ms = job->slack_ms;
+		row[i].active = job->active;
+		row[i].runs = job->runs;
+		row[i].piggybacked = job->piggybacked;
+		row[i].early_avg = job->runs ? job->early_ms / job->runs : 0;
+		/* On its own timer: one wakeup per period, or one for once */
+		ms = job->active_ms;
+		if (job->active)
+			ms += os_ticks_to_msec(now - job->since);
+		if (job->period_ms)
+			alone += ms / job->period_ms;
+		else
+			alone += job->runs;
+	}
+	runs = ns.runs;
+	wakeups = ns.wakeups;
+	piggybacks = ns.piggybacks;
+	os_mutex_put(&ns_mutex);
+
+	wmprintf("DTIM interval %d ms\r\n", dtim_ms);
+	wmprintf("%-12s %8s %8s %6s %6s %6s %10s\r\n", "job", "period", "slack",
+		 "state", "runs", "piggy", "early avg");
+	for (i = 0; i < n; i++)
+		wmprintf("%-12s %8d %8d %6s %6u %6u %10lu\r\n", row[i].name,
+			 row[i].period_ms, row[i].slack_ms,
+			 row[i].active ? "on" : "off", row[i].runs,
+			 row[i].piggybacked, row[i].early_avg);
+	wmprintf("runs %u in %u wakeups and %u piggybacks\r\n", runs,
+		 wakeups, piggybacks);
+	wmprintf("%u wakeups on separate timers, %d saved\r\n", alone,
+		 (int)(alone - wakeups));
+}
+
+static struct cli_command netsched_cmds[] = {
+	{"netsched", NULL, netsched_cmd},
+};
+
+int wm_demo_netsched_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(netsched_cmds) / sizeof(struct cli_command);
+	     i++)
+		if (cli_register_command(&netsched_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
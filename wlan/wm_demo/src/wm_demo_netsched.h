@@ -0,0 +1,70 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Network activity scheduler
+ *
+ * In IEEE power save, the WLAN chip sleeps between DTIM beacons and every
+ * transmission wakes it up. Periodic senders that each keep their own
+ * timer wake it up separately, even when they could just as well have
+ * gone out together.
+ *
+ * A job here is due period_ms after its last run, and may run up to
+ * slack_ms before it is due, never after: the guarantee to its receiver
+ * (a keepalive at least every period, a refresh no older than that) is
+ * unchanged, at the cost of a few more runs. A late job is the other way
+ * round, for things that must not happen early (stopping the micro-AP, a
+ * pause between two posts): it runs up to slack_ms after it is due, never
+ * before. A single timer fires at the earliest deadline, moved back to
+ * the DTIM interval when the slack of that job allows it, and every job
+ * whose window is open then runs in the same batch, back to back on the
+ * work queue. Sending anything else (wm_demo_netsched_radio_busy()) also runs
+ * the jobs whose window is open, without a wakeup of their own.
+ *
+ * The "netsched" CLI command shows the runs and the wakeups saved, against
+ * one wakeup per period of each job on its own timer.
+ */
+
+#ifndef _WM_DEMO_NETSCHED_H_
+#define _WM_DEMO_NETSCHED_H_
+
+#include <wmtypes.h>
+
+#define NETSCHED_MAX_JOBS	8
+
+struct netsched_job {
+	const char *name;
+	void (*fn)(void *arg);		/* run on the work queue */
+	void *arg;
+	int period_ms;			/* 0 to run once */
+	int slack_ms;
+	bool late;			/* slack after it is due, not before */
+	/* Owned by the scheduler */
+	bool active;
+	unsigned long due;		/* ticks */
+	unsigned runs;
+	unsigned piggybacked;		/* runs in a wakeup of another sender */
+	unsigned long early_ms;		/* total, before it was due */
+	unsigned long active_ms;	/* started, up to the last stop */
+	unsigned long since;		/* ticks, last start */
+};
+
+int wm_demo_netsched_init(void);
+
+/** Run job in delay_ms, then every job->period_ms. Starting a job that
+ * is already running moves its next run.
+ */
+int wm_demo_netsched_start(struct netsched_job *job, int delay_ms);
+void wm_demo_netsched_stop(struct netsched_job *job);
+
+/** Connected: take the DTIM interval of the AP */
+void wm_demo_netsched_link_up(void);
+
+/** The radio is awake for something else: run the jobs that may */
+void wm_demo_netsched_radio_busy(void);
+
+/** Register the "netsched" CLI command */
+int wm_demo_netsched_cli_init(void);
+
+#endif /* _WM_DEMO_NETSCHED_H_ */
@@ -0,0 +1,221 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wlan.h>
+#include <pwrmgr.h>
+#include <json.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <wm_demo_pm.h>
+
+static const char *pm_state_names[PM_STATE_COUNT] = {
+	"mcu-active", "mcu-pm2",
+	"wlan-active", "wlan-ieeeps", "wlan-deepsleep", "wlan-off",
+};
+
+struct pm_domain {
+	enum pm_state state;
+	unsigned long since;		/* ticks */
+};
+
+/* Updated from the idle task on PM2 entry and exit, under a critical
+ * section everywhere.
+ */
+static struct {
+	struct pm_domain mcu, wlan;
+	unsigned long start;
+	struct pm_state_stats st[PM_STATE_COUNT];
+} pm = {
+	.st = {
+		[PM_MCU_ACTIVE] = {.ua = PM_UA_MCU_ACTIVE},
+		[PM_MCU_PM2] = {.ua = PM_UA_MCU_PM2},
+		[PM_WLAN_ACTIVE] = {.ua = PM_UA_WLAN_ACTIVE},
+		[PM_WLAN_IEEEPS] = {.ua = PM_UA_WLAN_IEEEPS},
+		[PM_WLAN_DEEP_SLEEP] = {.ua = PM_UA_WLAN_DEEP_SLEEP},
+		[PM_WLAN_OFF] = {.ua = PM_UA_WLAN_OFF},
+	},
+};
+
+static void pm_enter(struct pm_domain *d, enum pm_state state)
+{
+	unsigned long now = os_ticks_get();
+	unsigned long flags;
+
+	flags = os_enter_critical_section();
+	if (d->state != state) {
+		pm.st[d->state].ms += os_ticks_to_msec(now - d->since);
+		d->state = state;
+		d->since = now;
+		pm.st[state].entries++;
+	}
+	os_exit_critical_section(flags);
+}
+
+#ifdef APPCONFIG_PM_ENABLE
+static void pm2_cb(power_save_event_t event, void *data)
+{
+	pm_enter(&pm.mcu, event == ACTION_ENTER_PM2 ?
+		 PM_MCU_PM2 : PM_MCU_ACTIVE);
+}
+#endif /* APPCONFIG_PM_ENABLE */
+
+void wm_demo_pm_reset(void)
+{
+	unsigned long flags;
+	int i;
+
+	flags = os_enter_critical_section();
+	pm.start = pm.mcu.since = pm.wlan.since = os_ticks_get();
+	for (i = 0; i < PM_STATE_COUNT; i++) {
+		pm.st[i].entries = 0;
+		pm.st[i].ms = 0;
+	}
+	pm.st[pm.mcu.state].entries = 1;
+	pm.st[pm.wlan.state].entries = 1;
+	os_exit_critical_section(flags);
+}
+
+int wm_demo_pm_init(void)
+{
+	pm.mcu.state = PM_MCU_ACTIVE;
+	pm.wlan.state = PM_WLAN_ACTIVE;
+	wm_demo_pm_reset();
+#ifdef APPCONFIG_PM_ENABLE
+	if (pm_register_cb(ACTION_ENTER_PM2 | ACTION_EXIT_PM2, pm2_cb,
+			   NULL) < 0)
+		return -WM_FAIL;
+#endif /* APPCONFIG_PM_ENABLE */
+	return WM_SUCCESS;
+}
+
+void wm_demo_pm_wlan_state(int ps_state)
+{
+	switch (ps_state) {
+	case WLAN_IEEE:
+		pm_enter(&pm.wlan, PM_WLAN_IEEEPS);
+		break;
+	case WLAN_DEEP_SLEEP:
+		pm_enter(&pm.wlan, PM_WLAN_DEEP_SLEEP);
+		break;
+	case WLAN_PDN:
+		pm_enter(&pm.wlan, PM_WLAN_OFF);
+		break;
+	default:
+		pm_enter(&pm.wlan, PM_WLAN_ACTIVE);
+		break;
+	}
+}
+
+int wm_demo_pm_set_ua(enum pm_state state, uint32_t ua)
+{
+	if (state >= PM_STATE_COUNT)
+		return -WM_E_INVAL;
+	pm.st[state].ua = ua;
+	return WM_SUCCESS;
+}
+
+void wm_demo_pm_get(struct pm_report *r)
+{
+	unsigned long now = os_ticks_get();
+	unsigned long flags;
+	uint64_t uams = 0;
+	int i;
+
+	flags = os_enter_critical_section();
+	memcpy(r->st, pm.st, sizeof(r->st));
+	r->ms = os_ticks_to_msec(now - pm.start);
+	r->st[pm.mcu.state].ms += os_ticks_to_msec(now - pm.mcu.since);
+	r->st[pm.wlan.state].ms += os_ticks_to_msec(now - pm.wlan.since);
+	os_exit_critical_section(flags);
+
+	for (i = 0; i < PM_STATE_COUNT; i++)
+		uams += (uint64_t)r->st[i].ua * r->st[i].ms;
+	r->uah = uams / (3600 * 1000);
+	r->mj = uams * PM_SUPPLY_MV / 1000000000;
+	r->avg_ua = r->ms ? uams / r->ms : 0;
+}
+
+static uint32_t pm_mean_ms(const struct pm_state_stats *s)
+{
+	return s->entries ? s->ms / s->entries : 0;
+}
+
+/* json_set_val_int() takes an int: past 24 days, stay at the top */
+static int pm_int(uint64_t v)
+{
+	return v > 0x7fffffff ? 0x7fffffff : v;
+}
+
+void wm_demo_pm_json(struct json_str *jstr)
+{
+	struct pm_report r;
+	int i;
+
+	wm_demo_pm_get(&r);
+	json_set_val_int(jstr, "ms", pm_int(r.ms));
+	for (i = 0; i < PM_STATE_COUNT; i++) {
+		json_push_object(jstr, pm_state_names[i]);
+		json_set_val_int(jstr, "n", pm_int(r.st[i].entries));
+		json_set_val_int(jstr, "ms", pm_int(r.st[i].ms));
+		json_set_val_int(jstr, "mean_ms",
+				 pm_int(pm_mean_ms(&r.st[i])));
+		json_set_val_int(jstr, "ua", pm_int(r.st[i].ua));
+		json_pop_object(jstr);
+	}
+	json_set_val_int(jstr, "uah", pm_int(r.uah));
+	json_set_val_int(jstr, "mj", pm_int(r.mj));
+	json_set_val_int(jstr, "avg_ua", pm_int(r.avg_ua));
+}
+
+static void pm_stats_cmd(int argc, char **argv)
+{
+	struct pm_report r;
+	int i;
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		wm_demo_pm_reset();
+		return;
+	}
+	if (argc == 3) {
+		for (i = 0; i < PM_STATE_COUNT; i++)
+			if (!strcmp(argv[1], pm_state_names[i]))
+				break;
+		if (wm_demo_pm_set_ua(i, atoi(argv[2])) != WM_SUCCESS)
+			wmprintf("Unknown state %s\r\n", argv[1]);
+		return;
+	}
+	if (argc != 1) {
+		wmprintf("Usage: %s [reset | <state> <uA>]\r\n", argv[0]);
+		return;
+	}
+
+	wm_demo_pm_get(&r);
+	wmprintf("%-15s %8s %12s %10s %8s\r\n", "state", "entries",
+		 "total (ms)", "mean (ms)", "uA");
+	for (i = 0; i < PM_STATE_COUNT; i++)
+		wmprintf("%-15s %8u %12u %10u %8u\r\n", pm_state_names[i],
+			 r.st[i].entries, (unsigned)r.st[i].ms,
+			 pm_mean_ms(&r.st[i]), r.st[i].ua);
+	wmprintf("over %u ms: %u uAh, %u mJ at %d mV, %u uA average\r\n",
+		 (unsigned)r.ms, (unsigned)r.uah, (unsigned)r.mj,
+		 PM_SUPPLY_MV, r.avg_ua);
+}
+
+static struct cli_command pm_cmds[] = {
+	{"pm-stats", "[reset | <state> <uA>]", pm_stats_cmd},
+};
+
+int wm_demo_pm_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(pm_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&pm_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Power state residency
+ *
+ * Counts the entries into and the time spent in each power state, for
+ * the MCU (active or PM2) and for the WLAN chip (active, IEEE power save,
+ * deep sleep or powered down) separately: both are in exactly one of their
+ * states at any time. A current model, the average draw in each state,
+ * turns the times into the charge taken from the battery, so that two
+ * firmware builds can be compared on the same test run.
+ *
+ * The default model is a rough guess for an MC200 with an 88W8801: measure
+ * the board and set it with the "pm-stats" CLI command.
+ */
+
+#ifndef _WM_DEMO_PM_H_
+#define _WM_DEMO_PM_H_
+
+#include <wmtypes.h>
+#include <json.h>
+
+enum pm_state {
+	PM_MCU_ACTIVE = 0,
+	PM_MCU_PM2,
+	PM_WLAN_ACTIVE,
+	PM_WLAN_IEEEPS,
+	PM_WLAN_DEEP_SLEEP,
+	PM_WLAN_OFF,
+	PM_STATE_COUNT,
+};
+
+/* Average current in each state, in microamperes */
+#define PM_UA_MCU_ACTIVE	20000
+#define PM_UA_MCU_PM2		60
+#define PM_UA_WLAN_ACTIVE	45000
+#define PM_UA_WLAN_IEEEPS	1500
+#define PM_UA_WLAN_DEEP_SLEEP	300
+#define PM_UA_WLAN_OFF		0
+#define PM_SUPPLY_MV		3300
+
+struct pm_state_stats {
+	uint32_t entries;
+	uint64_t ms;			/* total, current stay included */
+	uint32_t ua;			/* model */
+};
+
+struct pm_report {
+	uint64_t ms;			/* since boot or the last reset */
+	struct pm_state_stats st[PM_STATE_COUNT];
+	uint64_t uah;			/* charge, microampere-hours */
+	uint64_t mj;			/* energy at the supply voltage */
+	uint32_t avg_ua;
+};
+
+/** Start counting, both domains active. Hooks the PM2 entry and exit. */
+int wm_demo_pm_init(void);
+
+/** The WLAN chip entered ps_state (WLAN_IEEE, WLAN_DEEP_SLEEP, WLAN_PDN or
+ * WLAN_ACTIVE).
+ */
+void wm_demo_pm_wlan_state(int ps_state);
+
+void wm_demo_pm_get(struct pm_report *r);
+void wm_demo_pm_reset(void);
+
+/** Set the current of state in the model */
+int wm_demo_pm_set_ua(enum pm_state state, uint32_t ua);
+
+/** Add the report to jstr as "pm" members */
+void wm_demo_pm_json(struct json_str *jstr);
+
+/** Register the "pm-stats" CLI command */
+int wm_demo_pm_cli_init(void);
+
+#endif /* _WM_DEMO_PM_H_ */
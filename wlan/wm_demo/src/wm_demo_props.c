@@ -0,0 +1,275 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <json.h>
+#include <appln_dbg.h>
+#include <wmcloud.h>
+#include <wm_demo_props.h>
+
+struct wm_demo_prop {
+	const char *name;
+	prop_type_t type;
+	prop_get_fn_t get;
+	prop_set_fn_t set;
+	unsigned version;
+	unsigned dirty;
+};
+
+/* Everything is dirty at boot so that the first report on every channel
+ * carries the complete device state.
+ */
+#define PROP_ENTRY(_name, _type, _get, _set)				\
+	{ .name = #_name, .type = _type, .get = _get, .set = _set,	\
+	  .dirty = PROP_CH_ALL },
+static struct wm_demo_prop props[PROP_COUNT] = {
+	WM_DEMO_PROPS(PROP_ENTRY)
+};
+#undef PROP_ENTRY
+
+static os_mutex_t props_mutex;
+static unsigned props_gen;
+static void (*props_notify[PROPS_MAX_NOTIFY])(void);
+
+int wm_demo_props_init(void)
+{
+	int ret = os_mutex_create(&props_mutex, "props", OS_MUTEX_INHERIT);
+	if (ret != WM_SUCCESS)
+		dbg("Error: props mutex creation failed: %d", ret);
+	return ret;
+}
+
+int wm_demo_prop_find(const char *name)
+{
+	int id;
+
+	for (id = 0; id < PROP_COUNT; id++)
+		if (!strcmp(props[id].name, name))
+			return id;
+	return -WM_FAIL;
+}
+
+const char *wm_demo_prop_name(int id)
+{
+	if (id < 0 || id >= PROP_COUNT)
+		return NULL;
+	return props[id].name;
+}
+
+int wm_demo_prop_type(int id)
+{
+	if (id < 0 || id >= PROP_COUNT)
+		return -WM_E_INVAL;
+	return props[id].type;
+}
+
+int wm_demo_prop_get(int id, struct prop_val *val)
+{
+	if (id < 0 || id >= PROP_COUNT || !props[id].get)
+		return -WM_E_INVAL;
+
+	memset(val, 0, sizeof(*val));
+	return props[id].get(val);
+}
+
+static bool prop_val_equal(prop_type_t type, const struct prop_val *a,
+			   const struct prop_val *b)
+{
+	if (type == PROP_TYPE_STR) {
+		if (!a->s || !b->s)
+			return a->s == b->s;
+		return !strcmp(a->s, b->s);
+	}
+	return a->i == b->i;
+}
+
+int wm_demo_prop_set(int id, const struct prop_val *val)
+{
+	struct wm_demo_prop *p;
+	struct prop_val old, new;
+	bool changed = false;
+	int ret, i;
+
+	if (id < 0 || id >= PROP_COUNT)
+		return -WM_E_INVAL;
+
+	p = &props[id];
+	if (!p->set)
+		return -WM_E_PERM;
+
+	os_mutex_get(&props_mutex, OS_WAIT_FOREVER);
+	memset(&old, 0, sizeof(old));
+	p->get(&old);
+	ret = p->set(val);
+	if (ret == WM_SUCCESS) {
+		memset(&new, 0, sizeof(new));
+		p->get(&new);
+		if (!prop_val_equal(p->type, &old, &new)) {
+			p->version++;
+			p->dirty = PROP_CH_ALL;
+			props_gen++;
+			changed = true;
+		}
+	}
+	os_mutex_put(&props_mutex);
+
+	for (i = 0; changed && i < PROPS_MAX_NOTIFY && props_notify[i]; i++)
+		props_notify[i]();
+	return ret;
+}
+
+unsigned wm_demo_prop_version(int id)
+{
+	if (id < 0 || id >= PROP_COUNT)
+		return 0;
+	return props[id].version;
+}
+
+unsigned wm_demo_props_gen(void)
+{
+	return props_gen;
+}
+
+int wm_demo_props_add_notify(void (*fn)(void))
+{
+	int i;
+
+	for (i = 0; i < PROPS_MAX_NOTIFY; i++) {
+		if (props_notify[i] == fn)
+			return WM_SUCCESS;
+		if (!props_notify[i]) {
+			props_notify[i] = fn;
+			return WM_SUCCESS;
+		}
+	}
+	return -WM_E_NOMEM;
+}
+
+unsigned wm_demo_props_dirty(unsigned ch)
+{
+	unsigned mask = 0;
+	int id;
+
+	os_mutex_get(&props_mutex, OS_WAIT_FOREVER);
+	for (id = 0; id < PROP_COUNT; id++)
+		if (props[id].dirty & ch)
+			mask |= PROP_MASK(id);
+	os_mutex_put(&props_mutex);
+
+	return mask;
+}
+
+void wm_demo_props_clear_dirty(unsigned mask, unsigned ch)
+{
+	int id;
+
+	os_mutex_get(&props_mutex, OS_WAIT_FOREVER);
+	for (id = 0; id < PROP_COUNT; id++)
+		if (mask & PROP_MASK(id))
+			props[id].dirty &= ~ch;
+	os_mutex_put(&props_mutex);
+}
+
+void wm_demo_props_mark_dirty(unsigned mask, unsigned ch)
+{
+	int id;
+
+	os_mutex_get(&props_mutex, OS_WAIT_FOREVER);
+	for (id = 0; id < PROP_COUNT; id++)
+		if (mask & PROP_MASK(id))
+			props[id].dirty |= ch;
+	os_mutex_put(&props_mutex);
+}
+
+int wm_demo_props_encode(struct json_str *jstr, unsigned mask, unsigned ch)
+{
+	struct prop_val val;
+	int id, cnt = 0;
+
+	os_mutex_get(&props_mutex, OS_WAIT_FOREVER);
+	for (id = 0; id < PROP_COUNT; id++) {
+		if (!(mask & PROP_MASK(id)))
+			continue;
+		if (wm_demo_prop_get(id, &val) != WM_SUCCESS)
+			continue;
+
+		switch (props[id].type) {
+		case PROP_TYPE_BOOL:
+		case PROP_TYPE_INT:
+			json_set_val_int(jstr, props[id].name, val.i);
+			break;
+		case PROP_TYPE_STR:
+			json_set_val_str(jstr, props[id].name,
+					 val.s ? val.s : "");
+			break;
+		}
+		props[id].dirty &= ~ch;
+		cnt++;
+	}
+	os_mutex_put(&props_mutex);
+
+	return cnt;
+}
+
+unsigned wm_demo_props_snapshot(unsigned mask, unsigned ch,
+				struct prop_val *vals)
+{
+	unsigned read = 0;
+	int id;
+
+	os_mutex_get(&props_mutex, OS_WAIT_FOREVER);
+	for (id = 0; id < PROP_COUNT; id++) {
+		if (!(mask & PROP_MASK(id)))
+			continue;
+		if (wm_demo_prop_get(id, &vals[id]) != WM_SUCCESS)
+			continue;
+		props[id].dirty &= ~ch;
+		read |= PROP_MASK(id);
+	}
+	os_mutex_put(&props_mutex);
+
+	return read;
+}
+
+unsigned wm_demo_props_decode(struct json_object *obj)
+{
+	char buf[PROP_STR_MAXLEN + 1];
+	struct prop_val val;
+	unsigned mask = 0;
+	int id;
+
+	for (id = 0; id < PROP_COUNT; id++) {
+		const char *name = props[id].name;
+
+		memset(&val, 0, sizeof(val));
+		if (json_get_val_str(obj, name, buf, sizeof(buf))
+		    == WM_SUCCESS) {
+			if (!strncmp(buf, QUERY_STR, sizeof(buf))) {
+				dbg("prop %s query", name);
+				mask |= PROP_MASK(id);
+				continue;
+			}
+			if (props[id].type != PROP_TYPE_STR)
+				continue;
+			val.s = buf;
+		} else if (props[id].type != PROP_TYPE_STR &&
+			   json_get_val_int(obj, name, &val.i)
+			   == WM_SUCCESS) {
+			if (props[id].type == PROP_TYPE_BOOL &&
+			    val.i != 0 && val.i != 1)
+				continue;
+		} else {
+			continue;
+		}
+
+		if (wm_demo_prop_set(id, &val) == WM_SUCCESS) {
+			dbg("prop %s set", name);
+			mask |= PROP_MASK(id);
+		}
+	}
+
+	return mask;
+}
@@ -0,0 +1,174 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Device property registry
+ *
+ * Every piece of device state that is visible to the outside world (cloud
+ * channel, wmcloud backends, local HTTP) is declared exactly once in
+ * WM_DEMO_PROPS() below. The JSON encoders and decoders used by all the
+ * channels are driven by this table, so adding a property does not require
+ * any new hand-written JSON code.
+ *
+ * Each property carries a version (incremented on every change) and a
+ * dirty mask with one bit per channel. A channel reports only the
+ * properties whose bit is set and clears it once the value is encoded.
+ */
+
+#ifndef _WM_DEMO_PROPS_H_
+#define _WM_DEMO_PROPS_H_
+
+#include <wmtypes.h>
+#include <wmerrno.h>
+#include <json.h>
+
+/* Longest value accepted for a PROP_TYPE_STR property */
+#define PROP_STR_MAXLEN		64
+
+typedef enum {
+	PROP_TYPE_BOOL,
+	PROP_TYPE_INT,
+	PROP_TYPE_STR,
+} prop_type_t;
+
+struct prop_val {
+	int i;			/* PROP_TYPE_BOOL, PROP_TYPE_INT */
+	const char *s;		/* PROP_TYPE_STR */
+};
+
+/* Property getter and setter. Setters return WM_SUCCESS if the new value
+ * was accepted by the hardware/application.
+ */
+typedef int (*prop_get_fn_t)(struct prop_val *val);
+typedef int (*prop_set_fn_t)(const struct prop_val *val);
+
+/* Getters and setters referenced by the property table */
+int wm_demo_switch_get(struct prop_val *val);
+int wm_demo_switch_set(const struct prop_val *val);
+
+/*
+ * The device property table.
+ *
+ * P(name, type, getter, setter)
+ *
+ * name is used verbatim as the JSON key on every channel. A NULL setter
+ * makes the property read-only.
+ */
+#define WM_DEMO_PROPS(P)						\
+	P(onOff, PROP_TYPE_BOOL, wm_demo_switch_get, wm_demo_switch_set)
+
+#define PROP_ID(_name, _type, _get, _set)	PROP_ID_##_name,
+enum {
+	WM_DEMO_PROPS(PROP_ID)
+	PROP_COUNT
+};
+#undef PROP_ID
+
+/* Worst case length of an encoded value of each type, and of the complete
+ * "name":value list of all the properties. Used to size message buffers at
+ * compile time.
+ */
+#define PROP_TYPE_BOOL_MAXLEN	1
+#define PROP_TYPE_INT_MAXLEN	11
+#define PROP_TYPE_STR_MAXLEN	(2 + 2 * PROP_STR_MAXLEN)
+
+#define PROP_LEN(_name, _type, _get, _set)				\
+	(sizeof("\"" #_name "\":,") - 1 + _type##_MAXLEN) +
+#define WM_DEMO_PROPS_MAXLEN	(WM_DEMO_PROPS(PROP_LEN) 0)
+
+#define PROP_MASK(_id)		(1U << (_id))
+#define PROP_MASK_ALL		((1U << PROP_COUNT) - 1)
+
+/* Property consumers. Each one owns a bit in the per-property dirty mask. */
+#define PROP_CH_CLOUD		(1U << 0)	/* device channel (report) */
+#define PROP_CH_DEMO_CLOUD	(1U << 1)	/* wmcloud/xively/arrayent */
+#define PROP_CH_LOCAL		(1U << 2)	/* local event stream */
+#define PROP_CH_LAN		(1U << 3)	/* UDP local control */
+#define PROP_CH_MDNS		(1U << 4)	/* DNS-SD TXT record */
+#define PROP_CH_ALL		(PROP_CH_CLOUD | PROP_CH_DEMO_CLOUD | \
+				 PROP_CH_LOCAL | PROP_CH_LAN | PROP_CH_MDNS)
+
+int wm_demo_props_init(void);
+
+/** Look up a property id by its name. Returns -WM_FAIL if unknown. */
+int wm_demo_prop_find(const char *name);
+
+const char *wm_demo_prop_name(int id);
+/** The prop_type_t of a property, or -WM_E_INVAL if the id is unknown */
+int wm_demo_prop_type(int id);
+
+/** Read the current value of a property through its getter */
+int wm_demo_prop_get(int id, struct prop_val *val);
+
+/** Change a property through its setter. If the value actually changes,
+ * the property version is bumped and it is marked dirty on all channels.
+ */
+int wm_demo_prop_set(int id, const struct prop_val *val);
+
+static inline int wm_demo_prop_get_int(int id, int *i)
+{
+	struct prop_val val;
+	int ret = wm_demo_prop_get(id, &val);
+
+	if (ret == WM_SUCCESS)
+		*i = val.i;
+	return ret;
+}
+
+static inline int wm_demo_prop_set_int(int id, int i)
+{
+	struct prop_val val = { .i = i };
+
+	return wm_demo_prop_set(id, &val);
+}
+
+unsigned wm_demo_prop_version(int id);
+
+/** State generation: bumped whenever any property changes value */
+unsigned wm_demo_props_gen(void);
+
+/* Room for wm_demo_props_add_notify() callbacks */
+#define PROPS_MAX_NOTIFY	4
+
+/** Have fn called after a property changed value. It runs in the thread
+ * that changed it, with no lock held, and must not block: channels use it
+ * to wake up their own thread or post work. Returns -WM_E_NOMEM if
+ * PROPS_MAX_NOTIFY callbacks are registered already.
+ */
+int wm_demo_props_add_notify(void (*fn)(void));
+
+/** Mask of the properties that changed since channel ch last encoded them */
+unsigned wm_demo_props_dirty(unsigned ch);
+
+/** Mark the properties in mask as reported on channel ch. Used by
+ * channels that do not go through wm_demo_props_encode().
+ */
+void wm_demo_props_clear_dirty(unsigned mask, unsigned ch);
+
+/** Mark the properties in mask as pending on channel ch again, e.g. when
+ * sending them failed.
+ */
+void wm_demo_props_mark_dirty(unsigned mask, unsigned ch);
+
+/** Encode the properties selected by mask as "name":value pairs into the
+ * currently open JSON object and clear their dirty bit for channel ch.
+ * Returns the number of properties encoded.
+ */
+int wm_demo_props_encode(struct json_str *jstr, unsigned mask, unsigned ch);
+
+/** Read the properties selected by mask into vals[] (indexed by property
+ * id) and clear their dirty bit for channel ch. Returns the mask of the
+ * properties actually read.
+ */
+unsigned wm_demo_props_snapshot(unsigned mask, unsigned ch,
+				struct prop_val *vals);
+
+/** Decode every known property present in obj. Properties given a value
+ * are applied through their setters; properties given the query string
+ * "?" are only reported. Returns the mask of properties that were either
+ * set or queried so that the caller can echo them back.
+ */
+unsigned wm_demo_props_decode(struct json_object *obj);
+
+#endif /* _WM_DEMO_PROPS_H_ */
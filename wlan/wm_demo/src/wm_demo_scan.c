@@ -0,0 +1,403 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlan.h>
+#include <httpd.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <http_admit.h>
+#include <wm_demo_wq.h>
+#include <wm_demo_netsched.h>
+#include <wm_demo_scan.h>
+
+/* The scan results carry no noise floor, report a typical one so that
+ * clients can still work out a signal quality from rssi - nf.
+ */
+#define SCAN_NF			(-96)
+/* Smaller RSSI moves do not count as a change for incremental updates */
+#define SCAN_RSSI_HYST		3
+/* A network is dropped when it was missing from that many scans in a row */
+#define SCAN_MISSES_MAX		2
+#define SCAN_REMOVED_MAX	8
+
+#define SCAN_ENTRY_MAXLEN	(sizeof("[\"\",\"00:00:00:00:00:00\","	\
+				       "0,000,-000,-000],") +		\
+				 2 * IEEEtypes_SSID_SIZE)
+#define SCAN_RESP_LEN		(SCAN_MAX_NETWORKS * SCAN_ENTRY_MAXLEN + \
+				 SCAN_REMOVED_MAX * 24 + 96)
+
+struct scan_net {
+	char ssid[IEEEtypes_SSID_SIZE + 1];
+	uint8_t bssid[6];
+	uint8_t security;	/* as reported by the provisioning module */
+	uint8_t channel;
+	int8_t rssi;		/* dBm */
+	unsigned gen;		/* scan that added or last changed it */
+	unsigned seen;		/* last scan it was in */
+};
+
+static struct {
+	os_mutex_t mutex;
+	struct netsched_job job;
+	struct scan_net net[SCAN_MAX_NETWORKS];
+	int count;
+	unsigned gen;		/* completed scans */
+	unsigned long tick;	/* completion time of the last one */
+	struct {
+		uint8_t bssid[6];
+		unsigned gen;
+	} removed[SCAN_REMOVED_MAX];
+	int removed_next;
+	unsigned removed_lost;	/* removals before that gen are forgotten */
+	int interval;		/* seconds */
+	bool running;
+	bool scanning;
+	unsigned scans;
+	unsigned busy;		/* scans refused by the driver */
+} sc = {
+	.interval = APPCONFIG_SCAN_INTERVAL,
+};
+
+static uint8_t scan_security(const struct wlan_scan_result *res)
+{
+	if (res->wpa && res->wpa2)
+		return 5;
+	if (res->wpa2)
+		return 4;
+	if (res->wpa)
+		return 3;
+	if (res->wep)
+		return 1;
+	return 0;
+}
+
+static struct scan_net *scan_find(const char *bssid)
+{
+	int i;
+
+	for (i = 0; i < sc.count; i++)
+		if (!memcmp(sc.net[i].bssid, bssid, 6))
+			return &sc.net[i];
+	return NULL;
+}
+
+static void scan_remove(int i)
+{
+	memcpy(sc.removed[sc.removed_next].bssid, sc.net[i].bssid, 6);
+	if (sc.removed[sc.removed_next].gen > sc.removed_lost)
+		sc.removed_lost = sc.removed[sc.removed_next].gen;
+	sc.removed[sc.removed_next].gen = sc.gen;
+	sc.removed_next = (sc.removed_next + 1) % SCAN_REMOVED_MAX;
+
+	sc.net[i] = sc.net[--sc.count];
+}
+
+static void scan_update(const struct wlan_scan_result *res)
+{
+	struct scan_net *n = scan_find(res->bssid);
+	uint8_t security = scan_security(res);
+	int8_t rssi = -(int)res->rssi;
+	int i, weakest = 0;
+
+	if (!n) {
+		if (sc.count == SCAN_MAX_NETWORKS) {
+			/* Full: keep the strongest ones */
+			for (i = 1; i < sc.count; i++)
+				if (sc.net[i].rssi < sc.net[weakest].rssi)
+					weakest = i;
+			if (rssi <= sc.net[weakest].rssi)
+				return;
+			scan_remove(weakest);
+		}
+		n = &sc.net[sc.count++];
+		memset(n, 0, sizeof(*n));
+		memcpy(n->bssid, res->bssid, 6);
+	}
+
+	if (n->gen == 0 || n->security != security ||
+	    n->channel != res->channel ||
+	    abs(n->rssi - rssi) >= SCAN_RSSI_HYST ||
+	    strncmp(n->ssid, res->ssid, IEEEtypes_SSID_SIZE)) {
+		n->gen = sc.gen;
+		n->rssi = rssi;
+	}
+	strncpy(n->ssid, res->ssid, IEEEtypes_SSID_SIZE);
+	n->security = security;
+	n->channel = res->channel;
+	n->seen = sc.gen;
+}
+
+/* Strongest first */
+static void scan_sort(void)
+{
+	struct scan_net tmp;
+	int i, j;
+
+	for (i = 1; i < sc.count; i++) {
+		tmp = sc.net[i];
+		for (j = i; j > 0 && sc.net[j - 1].rssi < tmp.rssi; j--)
+			sc.net[j] = sc.net[j - 1];
+		sc.net[j] = tmp;
+	}
+}
+
+/* Called by the WLAN driver when the scan is complete */
+static int scan_cb(unsigned int count)
+{
+	struct wlan_scan_result res;
+	unsigned int i;
+
+	os_mutex_get(&sc.mutex, OS_WAIT_FOREVER);
+	sc.gen++;
+	for (i = 0; i < count; i++) {
+		if (wlan_get_scan_result(i, &res) != WM_SUCCESS)
+			break;
+		/* Hidden networks cannot be provisioned */
+		if (!res.ssid_len || !res.ssid[0])
+			continue;
+		scan_update(&res);
+	}
+	for (i = 0; i < sc.count; )
+		if (sc.gen - sc.net[i].seen >= SCAN_MISSES_MAX)
+			scan_remove(i);
+		else
+			i++;
+	scan_sort();
+	sc.tick = os_ticks_get();
+	sc.scans++;
+	sc.scanning = false;
+	os_mutex_put(&sc.mutex);
+
+	return WM_SUCCESS;
+}
+
+static void scan_work(void *arg)
+{
+	bool busy;
+
+	os_mutex_get(&sc.mutex, OS_WAIT_FOREVER);
+	busy = sc.scanning;
+	sc.scanning = true;
+	os_mutex_put(&sc.mutex);
+	if (busy)
+		return;
+
+	if (wlan_scan(scan_cb) != WM_SUCCESS) {
+		os_mutex_get(&sc.mutex, OS_WAIT_FOREVER);
+		sc.scanning = false;
+		sc.busy++;
+		os_mutex_put(&sc.mutex);
+	}
+}
+
+/* Refreshes may come a quarter of the interval early, along with other
+ * traffic
+ */
+static void scan_job_set(int interval)
+{
+	sc.job.period_ms = interval * 1000;
+	sc.job.slack_ms = interval * 1000 / 4;
+}
+
+/* Called with sc.mutex held */
+static unsigned scan_age_ms(void)
+{
+	return os_ticks_to_msec(os_ticks_get() - sc.tick);
+}
+
+/* Only " and \ need escaping in practice; control characters are dropped */
+static int scan_fmt_ssid(char *buf, const char *ssid)
+{
+	int n = 0;
+
+	for (; *ssid; ssid++) {
+		if ((unsigned char)*ssid < 0x20)
+			continue;
+		if (*ssid == '"' || *ssid == '\\')
+			buf[n++] = '\\';
+		buf[n++] = *ssid;
+	}
+	buf[n] = 0;
+	return n;
+}
+
+/* Called with sc.mutex held */
+static int scan_fmt(char *buf, int size, unsigned since)
+{
+	char ssid[2 * IEEEtypes_SSID_SIZE + 1];
+	const uint8_t *b;
+	bool full, first = true;
+	int i, len;
+
+	full = !since || since > sc.gen || since < sc.removed_lost;
+
+	len = snprintf(buf, size, "{\"networks\":[");
+	for (i = 0; i < sc.count; i++) {
+		if (!full && sc.net[i].gen <= since)
+			continue;
+		scan_fmt_ssid(ssid, sc.net[i].ssid);
+		b = sc.net[i].bssid;
+		len += snprintf(buf + len, size - len,
+				"%s[\"%s\",\"%02x:%02x:%02x:%02x:%02x:%02x\","
+				"%d,%d,%d,%d]", first ? "" : ",", ssid,
+				b[0], b[1], b[2], b[3], b[4], b[5],
+				sc.net[i].security, sc.net[i].channel,
+				sc.net[i].rssi, SCAN_NF);
+		first = false;
+	}
+	len += snprintf(buf + len, size - len, "]");
+
+	if (since && !full) {
+		len += snprintf(buf + len, size - len, ",\"removed\":[");
+		first = true;
+		for (i = 0; i < SCAN_REMOVED_MAX; i++) {
+			if (sc.removed[i].gen <= since)
+				continue;
+			b = sc.removed[i].bssid;
+			len += snprintf(buf + len, size - len,
+					"%s\"%02x:%02x:%02x:%02x:%02x:%02x\"",
+					first ? "" : ",",
+					b[0], b[1], b[2], b[3], b[4], b[5]);
+			first = false;
+		}
+		len += snprintf(buf + len, size - len, "]");
+	} else if (since) {
+		len += snprintf(buf + len, size - len, ",\"full\":1");
+	}
+
+	len += snprintf(buf + len, size - len, ",\"age\":%d,\"gen\":%u}",
+			sc.gen ? (int)scan_age_ms() : -1, sc.gen);
+	return len;
+}
+
+static int scan_get_handler(httpd_request_t *req)
+{
+	const char *q = strstr(req->filename, "since=");
+	unsigned since = q ? strtoul(q + 6, NULL, 10) : 0;
+	bool stale;
+	char *buf;
+	int len, ret;
+
+	buf = os_mem_alloc(SCAN_RESP_LEN);
+	if (!buf)
+		return -WM_E_NOMEM;
+
+	os_mutex_get(&sc.mutex, OS_WAIT_FOREVER);
+	len = scan_fmt(buf, SCAN_RESP_LEN, since);
+	stale = !sc.gen || scan_age_ms() >= sc.interval * 1000;
+	os_mutex_put(&sc.mutex);
+
+	/* Outside provisioning, refresh on demand, for the next request */
+	if (stale && !sc.running)
+		wm_demo_wq_post(WQ_PRIO_LOW, scan_work, NULL);
+
+	ret = httpd_send_response(req, HTTP_RES_200, buf, len,
+				  HTTP_CONTENT_JSON_STR);
+	os_mem_free(buf);
+	return ret;
+}
+
+static int scan_get(httpd_request_t *req)
+{
+	return http_admit_call(req, scan_get_handler);
+}
+
+static struct httpd_wsgi_call scan_wsgi = {
+	"/sys/scan", HTTPD_DEFAULT_HDR_FLAGS | HTTPD_HDR_ADD_PRAGMA_NO_CACHE,
+	0, scan_get, NULL, NULL, NULL
+};
+
+void wm_demo_scan_start(void)
+{
+	if (sc.running)
+		return;
+	sc.running = true;
+	wm_demo_wq_post(WQ_PRIO_LOW, scan_work, NULL);
+	wm_demo_netsched_start(&sc.job, sc.job.period_ms);
+}
+
+void wm_demo_scan_stop(void)
+{
+	if (!sc.running)
+		return;
+	sc.running = false;
+	wm_demo_netsched_stop(&sc.job);
+}
+
+static void scan_cache_cmd(int argc, char **argv)
+{
+	const uint8_t *b;
+	int i, interval;
+
+	if (argc == 2) {
+		interval = atoi(argv[1]);
+		if (interval <= 0) {
+			wmprintf("Usage: %s [interval in s]\r\n", argv[0]);
+			return;
+		}
+		sc.interval = interval;
+		scan_job_set(interval);
+		if (sc.running)
+			wm_demo_netsched_start(&sc.job, sc.job.period_ms);
+	}
+
+	os_mutex_get(&sc.mutex, OS_WAIT_FOREVER);
+	wmprintf("%s, every %d s, %u scans (%u refused), gen %u, age %d ms"
+		 "\r\n", sc.running ? "running" : "stopped", sc.interval,
+		 sc.scans, sc.busy, sc.gen, sc.gen ? (int)scan_age_ms() : -1);
+	for (i = 0; i < sc.count; i++) {
+		b = sc.net[i].bssid;
+		wmprintf("%4d %3d %02x:%02x:%02x:%02x:%02x:%02x %d %s\r\n",
+			 sc.net[i].rssi, sc.net[i].channel, b[0], b[1], b[2],
+			 b[3], b[4], b[5], sc.net[i].security,
+			 sc.net[i].ssid);
+	}
+	os_mutex_put(&sc.mutex);
+}
+
+static struct cli_command scan_cmds[] = {
+	{"scan-cache", "[interval in s]", scan_cache_cmd},
+};
+
+/* The command is registered at boot, long before WLAN is up */
+static int scan_mutex_init(void)
+{
+	if (sc.mutex)
+		return WM_SUCCESS;
+	return os_mutex_create(&sc.mutex, "scan", OS_MUTEX_INHERIT);
+}
+
+int wm_demo_scan_cli_init(void)
+{
+	int i;
+
+	if (scan_mutex_init() != WM_SUCCESS)
+		return -WM_FAIL;
+	for (i = 0; i < sizeof(scan_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&scan_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
+
+int wm_demo_scan_init(void)
+{
+	int ret;
+
+	if (sc.job.fn)
+		return WM_SUCCESS;
+
+	ret = scan_mutex_init();
+	if (ret != WM_SUCCESS)
+		return ret;
+
+	sc.job.name = "scan";
+	sc.job.fn = scan_work;
+	scan_job_set(sc.interval);
+
+	return httpd_register_wsgi_handler(&scan_wsgi);
+}
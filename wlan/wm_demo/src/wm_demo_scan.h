@@ -0,0 +1,49 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Cached background Wi-Fi scan
+ *
+ * While provisioning, the networks around are scanned in the background
+ * every APPCONFIG_SCAN_INTERVAL seconds into a table sorted by RSSI. This
+ * module serves /sys/scan from that table right away instead of scanning
+ * on every request, which blocked the HTTP server and took the radio off
+ * the micro-AP channel each time the provisioning page polled:
+ *
+ *   {"networks":[["ssid","bssid",security,channel,rssi,nf],...],
+ *    "age":<ms since the scan>,"gen":<scan generation>}
+ *
+ * With ?since=<gen>, only the networks that appeared or changed after that
+ * generation are listed, plus the BSSIDs of those that went away in
+ * "removed". "full":1 is set if the changes are not known that far back
+ * and the complete table was sent instead.
+ *
+ * Outside provisioning, a request for a stale table triggers one
+ * background scan; the response is still the cached table.
+ */
+
+#ifndef _WM_DEMO_SCAN_H_
+#define _WM_DEMO_SCAN_H_
+
+#ifndef APPCONFIG_SCAN_INTERVAL
+#define APPCONFIG_SCAN_INTERVAL	15
+#endif
+
+#define SCAN_MAX_NETWORKS	16
+
+/** Register the /sys/scan handler. Call after the HTTP server is started
+ * and before provisioning, so that it takes precedence over the scanning
+ * handler of the provisioning module.
+ */
+int wm_demo_scan_init(void);
+
+/** Start and stop periodic scanning, e.g. on the micro-AP provisioning
+ * network.
+ */
+void wm_demo_scan_start(void);
+void wm_demo_scan_stop(void);
+
+int wm_demo_scan_cli_init(void);
+
+#endif /* _WM_DEMO_SCAN_H_ */
@@ -0,0 +1,258 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+#include <wmstdio.h>
+#include <wm_os.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <cli.h>
+#include <appln_dbg.h>
+#include <wm_demo_wq.h>
+
+struct wq_item {
+	wq_fn_t fn;
+	void *arg;
+	unsigned long posted;	/* ticks */
+};
+
+struct wq_counters {
+	unsigned posted;
+	unsigned done;
+	unsigned dropped;
+	unsigned max_depth;
+	unsigned long lat_sum_ms;
+	unsigned lat_max_ms;
+	unsigned run_max_ms;
+};
+
+static os_queue_t wq_queue[WQ_PRIO_COUNT];
+#define WQ_POOL_SIZE		(WQ_QUEUE_LEN * sizeof(struct wq_item))
+static os_queue_pool_define(wq_pool_high, WQ_POOL_SIZE);
+static os_queue_pool_define(wq_pool_low, WQ_POOL_SIZE);
+
+/* One count per queued item, whatever its priority */
+static os_semaphore_t wq_sem;
+
+static os_thread_t wq_thread[WQ_MAX_WORKERS];
+static os_thread_stack_define(wq_stack_0, APPCONFIG_WQ_STACK_SIZE);
+static os_thread_stack_define(wq_stack_1, APPCONFIG_WQ_STACK_SIZE);
+static os_thread_stack_define(wq_stack_2, APPCONFIG_WQ_STACK_SIZE);
+static os_thread_stack_t *wq_stack[WQ_MAX_WORKERS] = {
+	&wq_stack_0, &wq_stack_1, &wq_stack_2,
+};
+
+static struct wq_counters wq_cnt[WQ_PRIO_COUNT];
+static int wq_workers;
+
+static void wq_run(wq_prio_t prio, struct wq_item *item)
+{
+	struct wq_counters *cnt = &wq_cnt[prio];
+	unsigned long start = os_ticks_get();
+	unsigned lat_ms = os_ticks_to_msec(start - item->posted);
+	unsigned run_ms;
+	unsigned long flags;
+
+	item->fn(item->arg);
+	run_ms = os_ticks_to_msec(os_ticks_get() - start);
+
+	flags = os_enter_critical_section();
+	cnt->done++;
+	cnt->lat_sum_ms += lat_ms;
+	if (lat_ms > cnt->lat_max_ms)
+		cnt->lat_max_ms = lat_ms;
+	if (run_ms > cnt->run_max_ms)
+		cnt->run_max_ms = run_ms;
+	os_exit_critical_section(flags);
+}
+
+static void wq_worker(os_thread_arg_t arg)
+{
+	struct wq_item item;
+	int prio;
+
+	while (1) {
+		os_semaphore_get(&wq_sem, OS_WAIT_FOREVER);
+		for (prio = 0; prio < WQ_PRIO_COUNT; prio++) {
+			if (os_queue_recv(&wq_queue[prio], &item, OS_NO_WAIT)
+			    == WM_SUCCESS) {
+				wq_run(prio, &item);
+				break;
+			}
+		}
+	}
+}
+
+int wm_demo_wq_post(wq_prio_t prio, wq_fn_t fn, void *arg)
+{
+	struct wq_counters *cnt;
+	struct wq_item item;
+	unsigned long flags;
+	unsigned depth;
+
+	if (prio >= WQ_PRIO_COUNT || !fn)
+		return -WM_E_INVAL;
+	if (!wq_workers)
+		return -WM_FAIL;
+
+	cnt = &wq_cnt[prio];
+	item.fn = fn;
+	item.arg = arg;
+	item.posted = os_ticks_get();
+
+	if (os_queue_send(&wq_queue[prio], &item, OS_NO_WAIT) != WM_SUCCESS) {
+		flags = os_enter_critical_section();
+		cnt->dropped++;
+		os_exit_critical_section(flags);
+		dbg("Error: work queue %d full", prio);
+		return -WM_E_NOMEM;
+	}
+
+	depth = os_queue_get_msgs_waiting(&wq_queue[prio]);
+	flags = os_enter_critical_section();
+	cnt->posted++;
+	if (depth > cnt->max_depth)
+		cnt->max_depth = depth;
+	os_exit_critical_section(flags);
+
+	os_semaphore_put(&wq_sem);
+	return WM_SUCCESS;
+}
+
+static void wq_delayed_cb(os_timer_arg_t handle)
+{
+	struct wq_delayed *dw = os_timer_get_context(&handle);
+
+	wm_demo_wq_post(dw->prio, dw->fn, dw->arg);
+}
+
+int wm_demo_wq_delayed_init(struct wq_delayed *dw, wq_prio_t prio,
+			    wq_fn_t fn, void *arg)
+{
+	if (prio >= WQ_PRIO_COUNT || !fn)
+		return -WM_E_INVAL;
+
+	dw->prio = prio;
+	dw->fn = fn;
+	dw->arg = arg;
+	return os_timer_create(&dw->timer, "wq-delayed", 1, wq_delayed_cb, dw,
+			       OS_TIMER_ONE_SHOT, OS_TIMER_NO_ACTIVATE);
+}
+
+int wm_demo_wq_post_delayed(struct wq_delayed *dw, int ms)
+{
+	int ret;
+
+	if (ms <= 0)
+		return wm_demo_wq_post(dw->prio, dw->fn, dw->arg);
+
+	/* Never wait for the timer queue */
+	ret = os_timer_change(&dw->timer, os_msec_to_ticks(ms), 0);
+	if (ret == WM_SUCCESS)
+		ret = os_timer_activate(&dw->timer);
+	return ret;
+}
+
+void wm_demo_wq_cancel_delayed(struct wq_delayed *dw)
+{
+	os_timer_deactivate(&dw->timer);
+}
+
+void wm_demo_wq_get_stats(wq_prio_t prio, struct wq_stats *stats)
+{
+	struct wq_counters cnt;
+	unsigned long flags;
+
+	memset(stats, 0, sizeof(*stats));
+	if (prio >= WQ_PRIO_COUNT)
+		return;
+
+	flags = os_enter_critical_section();
+	cnt = wq_cnt[prio];
+	os_exit_critical_section(flags);
+
+	stats->posted = cnt.posted;
+	stats->done = cnt.done;
+	stats->dropped = cnt.dropped;
+	stats->max_depth = cnt.max_depth;
+	stats->lat_avg_ms = cnt.done ? cnt.lat_sum_ms / cnt.done : 0;
+	stats->lat_max_ms = cnt.lat_max_ms;
+	stats->run_max_ms = cnt.run_max_ms;
+	if (wq_workers)
+		stats->depth = os_queue_get_msgs_waiting(&wq_queue[prio]);
+}
+
+int wm_demo_wq_init(int workers)
+{
+	static const char *names[WQ_MAX_WORKERS] = { "wq0", "wq1", "wq2" };
+	int ret, i;
+
+	if (wq_workers)
+		return WM_SUCCESS;
+	if (workers < 1 || workers > WQ_MAX_WORKERS)
+		return -WM_E_INVAL;
+
+	ret = os_queue_create(&wq_queue[WQ_PRIO_HIGH], "wq-high",
+			      sizeof(struct wq_item), &wq_pool_high);
+	if (ret == WM_SUCCESS)
+		ret = os_queue_create(&wq_queue[WQ_PRIO_LOW], "wq-low",
+				      sizeof(struct wq_item), &wq_pool_low);
+	if (ret == WM_SUCCESS)
+		ret = os_semaphore_create_counting(&wq_sem, "wq-sem",
+						   WQ_PRIO_COUNT * WQ_QUEUE_LEN,
+						   0);
+	if (ret != WM_SUCCESS) {
+		dbg("Error: work queue creation failed: %d", ret);
+		return ret;
+	}
+
+	for (i = 0; i < workers; i++) {
+		ret = os_thread_create(&wq_thread[i], names[i], wq_worker,
+				       0, wq_stack[i], OS_PRIO_2);
+		if (ret != WM_SUCCESS) {
+			dbg("Error: work queue thread %d failed: %d", i, ret);
+			break;
+		}
+		wq_workers++;
+	}
+
+	return wq_workers ? WM_SUCCESS : ret;
+}
+
+static void wq_stats_cmd(int argc, char **argv)
+{
+	static const char *prio_name[WQ_PRIO_COUNT] = { "high", "low" };
+	struct wq_stats st;
+	int prio, i;
+
+	wmprintf("workers: %d\r\n", wq_workers);
+	/* Least free stack so far, in bytes */
+	for (i = 0; i < wq_workers; i++)
+		wmprintf("wq%d stack %d free %u\r\n", i,
+			 APPCONFIG_WQ_STACK_SIZE, (unsigned)
+			 uxTaskGetStackHighWaterMark(wq_thread[i]) *
+			 sizeof(portSTACK_TYPE));
+	for (prio = 0; prio < WQ_PRIO_COUNT; prio++) {
+		wm_demo_wq_get_stats(prio, &st);
+		wmprintf("%-4s posted %u done %u dropped %u depth %u/%u "
+			 "latency avg %u max %u ms run max %u ms\r\n",
+			 prio_name[prio], st.posted, st.done, st.dropped,
+			 st.depth, st.max_depth, st.lat_avg_ms, st.lat_max_ms,
+			 st.run_max_ms);
+	}
+}
+
+static struct cli_command wq_cmds[] = {
+	{"wq-stats", NULL, wq_stats_cmd},
+};
+
+int wm_demo_wq_cli_init(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(wq_cmds) / sizeof(struct cli_command); i++)
+		if (cli_register_command(&wq_cmds[i]))
+			return -WM_FAIL;
+	return WM_SUCCESS;
+}
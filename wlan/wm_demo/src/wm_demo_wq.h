@@ -0,0 +1,91 @@
+/*
+ *  Copyright (C) 2008-2015, Marvell International Ltd.
+ *  All Rights Reserved.
+ */
+
+/* Deferred work queue
+ *
+ * Application framework events are delivered one at a time on the
+ * framework thread. Anything slow done in an event handler (sleeps,
+ * restarting a server, network I/O) delays every event queued behind it.
+ * Handlers post such work here and return immediately; it is run by a
+ * small pool of worker threads.
+ *
+ * Items of WQ_PRIO_HIGH are always picked before WQ_PRIO_LOW ones. With
+ * more than one worker, items may run concurrently and finish out of
+ * order.
+ */
+
+#ifndef _WM_DEMO_WQ_H_
+#define _WM_DEMO_WQ_H_
+
+#include <wmtypes.h>
+#include <wm_os.h>
+
+/* Number of worker threads started by wm_demo_wq_init() */
+#ifndef APPCONFIG_WQ_WORKERS
+#define APPCONFIG_WQ_WORKERS	2
+#endif
+
+#define WQ_MAX_WORKERS		3
+#define WQ_QUEUE_LEN		8	/* per priority */
+
+/* Stack of each worker. Items call into PSM, httpd and the JSON code: check
+ * the free stack "wq-stats" reports after a run before lowering it.
+ */
+#ifndef APPCONFIG_WQ_STACK_SIZE
+#define APPCONFIG_WQ_STACK_SIZE	2048
+#endif
+
+typedef enum {
+	WQ_PRIO_HIGH,
+	WQ_PRIO_LOW,
+	WQ_PRIO_COUNT,
+} wq_prio_t;
+
+typedef void (*wq_fn_t)(void *arg);
+
+/* Work item posted once a delay has passed */
+struct wq_delayed {
+	os_timer_t timer;
+	wq_prio_t prio;
+	wq_fn_t fn;
+	void *arg;
+};
+
+struct wq_stats {
+	unsigned posted;
+	unsigned done;
+	unsigned dropped;	/* queue was full */
+	unsigned depth;		/* items waiting now */
+	unsigned max_depth;
+	unsigned lat_avg_ms;	/* post to start of execution */
+	unsigned lat_max_ms;
+	unsigned run_max_ms;	/* execution time */
+};
+
+int wm_demo_wq_init(int workers);
+
+/** Queue fn(arg) for execution on a worker thread. Never blocks.
+ * Returns -WM_E_NOMEM if the queue of that priority is full.
+ */
+int wm_demo_wq_post(wq_prio_t prio, wq_fn_t fn, void *arg);
+
+/** Create the timer of a delayed work item */
+int wm_demo_wq_delayed_init(struct wq_delayed *dw, wq_prio_t prio,
+			    wq_fn_t fn, void *arg);
+
+/** Post dw->fn(dw->arg) in ms milliseconds, in place of any pending post
+ * of dw. Never blocks.
+ */
+int wm_demo_wq_post_delayed(struct wq_delayed *dw, int ms);
+
+/** Drop the pending post of dw, if any */
+void wm_demo_wq_cancel_delayed(struct wq_delayed *dw);
+
+void wm_demo_wq_get_stats(wq_prio_t prio, struct wq_stats *stats);
+
+/** Register the "wq-stats" CLI command */
+int wm_demo_wq_cli_init(void);
+
+#endif /* _WM_DEMO_WQ_H_ */
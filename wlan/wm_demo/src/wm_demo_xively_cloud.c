@@ -9,11 +9,11 @@
 #include <appln_dbg.h>
 #include <psm.h>
 #include <wmcloud_xively.h>
+#include <wm_demo_props.h>
 
 #if APPCONFIG_DEMO_CLOUD
 #define DEVICE_CLASS	"wm_demo"
 #endif  /* APPCONFIG_DEMO_CLOUD */
-static int led_state;
 
 char xively_product_secret[] = { 0x15, 0xe1, 0x03, 0xeb, 0xba, 0x62, 0x02, 0x45,
 				0x2e, 0x9d, 0xa6, 0xfb, 0x62, 0x38, 0xe1, 0x69,
@@ -60,13 +60,12 @@ int do_cloud_post(xi_context_t *xi)
 	int target_state_val = xi_get_value_i32(target_state);
 	cl_dbg("Target State: %d\r\n", target_state_val);
 
-	if (target_state_val == 1) {
-		board_led_on(board_led_2());
-		led_state = 1;
-	} else if (target_state_val == 0) {
-		board_led_off(board_led_2());
-		led_state = 0;
-	}
+	/* target_state is -1 when there is no pending request */
+	if (target_state_val == 1 || target_state_val == 0)
+		wm_demo_prop_set_int(PROP_ID_onOff, target_state_val);
+
+	int led_state = 0;
+	wm_demo_prop_get_int(PROP_ID_onOff, &led_state);
 	cl_dbg("Sending Current State: %d\r\n", led_state);
 
 	xi_set_value_i32(current_state, led_state);
@@ -43,7 +43,9 @@
 		},
 		"diag" {
 		   "diag_live":"?",
-		   "diag_history":"?"
+		   "diag_history":"?",
+		   "pm":"?",
+		   "wake":"?"
 		},
 		"reboot":1,
 		"rssi":"?",
@@ -445,14 +447,27 @@ end:
 	return ret;
 }
 
+void cloud_set_post_done(void (*post_done)(int status))
+{
+	c.app_cloud_post_done = post_done;
+}
+
 int cloud_actual_start(const char *dev_class, void (*handle_req)(struct json_str
 		*jstr, struct json_object *obj, bool *repeat_POST),
 		void (*periodic_post)(struct json_str *jstr),
 		unsigned int stack_size)
 {
 	int ret;
+	/* The sequence number survives restarts of the cloud so that the
+	 * server does not mistake new requests for replays.
+	 */
+	long long sequence = c.sequence;
+	void (*post_done)(int status) = c.app_cloud_post_done;
+
 	/* Cloud specific initialization */
 	memset(&c, 0x00, sizeof(cloud_t));
+	c.sequence = sequence;
+	c.app_cloud_post_done = post_done;
 	app_sys_get_uuid(c.uuid, UUID_MAX_LEN);
 	/* If HTTPS is enabled, then large stack is required: around 12k
 	 * So override the input value with 12k size */
@@ -105,6 +105,8 @@ struct cloud {
 	void (*app_cloud_periodic_post) (struct json_str *jstr);
 	void (*app_cloud_handle_req) (struct json_str *jstr, struct json_object
 				      *obj, bool *repeat_POST);
+	/* Outcome of the post built by app_cloud_periodic_post */
+	void (*app_cloud_post_done) (int status);
 };
 
 /* PSM variables for the cloud */
@@ -121,6 +123,8 @@ struct cloud {
 #define J_NAME_REBOOT           "reboot"
 #define J_NAME_DIAG_LIVE        "diag_live"
 #define J_NAME_DIAG_HISTORY     "diag_history"
+#define J_NAME_DIAG_PM          "pm"
+#define J_NAME_DIAG_WAKE        "wake"
 #define J_NAME_UUID             "uuid"
 #define J_NAME_CLOUD            "cloud"
 #define J_NAME_SEQUENCE         "sequence"
@@ -143,6 +147,11 @@ int cloud_actual_start(const char *dev_class, void (*handle_req)(struct json_str
 		void (*periodic_post)(struct json_str *jstr),
 		unsigned int stack_size);
 int cloud_actual_stop(void);
+/** Have post_done told whether each post went through (WM_SUCCESS once
+ * the server answered), so that what it carried can be sent again if not.
+ * Survives cloud restarts.
+ */
+void cloud_set_post_done(void (*post_done)(int status));
 int cloud_params_load(cloud_t *c);
 int cloud_wakeup_for_send();
 void cloud_process_server_response(cloud_t *c, unsigned len,
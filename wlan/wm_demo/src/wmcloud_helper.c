@@ -7,6 +7,8 @@
 #include <httpc.h>
 #include <app_framework.h>
 #include <wmcloud.h>
+#include <wm_demo_pm.h>
+#include <wake_audit.h>
 
 extern cloud_t c;
 static os_thread_t app_reboot_thread;
@@ -211,6 +213,25 @@ static void cloud_handle_diag(cloud_t *c, struct json_str *jstr,
 			*repeat_POST = true;
 		}
 	}
+
+	/* Power state residency, to compare firmware builds on battery */
+	if (json_get_val_str(obj, J_NAME_DIAG_PM, buf, 16) == WM_SUCCESS) {
+		if (strncmp(buf, QUERY_STR, 16) == 0) {
+			json_push_object(jstr, J_NAME_DIAG_PM);
+			wm_demo_pm_json(jstr);
+			json_pop_object(jstr);
+			*repeat_POST = true;
+		}
+	}
+
+	if (json_get_val_str(obj, J_NAME_DIAG_WAKE, buf, 16) == WM_SUCCESS) {
+		if (strncmp(buf, QUERY_STR, 16) == 0) {
+			json_push_object(jstr, J_NAME_DIAG_WAKE);
+			wake_audit_json(jstr);
+			json_pop_object(jstr);
+			*repeat_POST = true;
+		}
+	}
 	json_pop_object(jstr);
 }
 
@@ -4,6 +4,8 @@
  */
 #include <httpc.h>
 #include <wmcloud.h>
+#include <wake_audit.h>
+#include <wm_demo_netsched.h>
 #if APPCONFIG_HTTPS_CLOUD
 #include "ca_cert_pem.h"
 #include <wm-tls.h>
@@ -11,6 +13,8 @@
 #define CLOUD_DUMP_DATA
 extern cloud_t c;
 static os_semaphore_t sem;
+/* Keeps cloud_next_post() from putting sem while cloud_stop() deletes it */
+static os_mutex_t sem_mutex;
 
 static uint8_t is_cloud_started;
 int wmcloud_get_ui_link(httpd_request_t *req);
@@ -124,6 +128,12 @@ int cloud_get_ui_link(httpd_request_t *req)
 	return wmcloud_get_ui_link(req);
 }
 
+static void cloud_post_done(int status)
+{
+	if (c.app_cloud_post_done)
+		c.app_cloud_post_done(status);
+}
+
 static void cloud_loop()
 {
 	int ret;
@@ -139,6 +149,7 @@ static void cloud_loop()
 	/* create_transmit_packet() returns the length of tx packet */
 	if (ret == 0) {
 		cloud_sm(EVT_INT_ERROR);
+		cloud_post_done(-WM_FAIL);
 		return;
 	}
 
@@ -146,6 +157,7 @@ static void cloud_loop()
 	ret = connect_to_cloud(&c, &c.hS);
 	if (ret != WM_SUCCESS) {
 		cloud_sm(EVT_CONN_ERROR);
+		cloud_post_done(ret);
 		return;
 	}
 
@@ -163,6 +175,7 @@ begin:
 	ret = send_cloud_post(&c, c.hS);
 	if (ret != WM_SUCCESS) {
 		cloud_sm(EVT_TX_ERROR);
+		cloud_post_done(ret);
 		if (c.hS)
 			http_close_session(&c.hS);
 		return;
@@ -181,15 +194,19 @@ begin:
 		if (ret == -WM_E_HTTPC_SOCKET_ERROR && errno == EAGAIN)
 			continue;
 
+		cloud_post_done(ret);
 		http_close_session(&c.hS);
 		return;
 	} while (!c.stop_request);
 
 	if (c.stop_request) {
+		cloud_post_done(-WM_FAIL);
 		if (c.hS)
 			http_close_session(&c.hS);
 		return;
 	}
+	/* Before the response may build the next packet */
+	cloud_post_done(WM_SUCCESS);
 
 #ifdef CLOUD_DUMP_DATA
 	cl_dbg("RECV: Cloud packet:");
@@ -204,9 +221,30 @@ begin:
 	http_close_session(&c.hS);
 }
 
-static void cloud_sleep(cloud_t *c)
+static void cloud_next_post(void *arg)
+{
+	/* May have been queued just before cloud_stop() */
+	os_mutex_get(&sem_mutex, OS_WAIT_FOREVER);
+	if (is_cloud_started)
+		os_semaphore_put(&sem);
+	os_mutex_put(&sem_mutex);
+}
+
+/* Pause between two posts, ended with the other network jobs: not before
+ * the 100 ms are up, and up to as much later
+ */
+static struct netsched_job cloud_job = {
+	.name = "cloud-post",
+	.fn = cloud_next_post,
+	.slack_ms = 100,
+	.late = true,
+};
+
+static int cloud_sleep(cloud_t *c)
 {
-	os_semaphore_get(&sem, os_msec_to_ticks(100));
+	if (wm_demo_netsched_start(&cloud_job, 100) != WM_SUCCESS)
+		return os_semaphore_get(&sem, os_msec_to_ticks(100));
+	return os_semaphore_get(&sem, OS_WAIT_FOREVER);
 }
 
 int cloud_wakeup_for_send()
@@ -215,9 +253,20 @@ int cloud_wakeup_for_send()
 }
 void cloud_thread_main(os_thread_arg_t arg)
 {
+	static struct wake_point wp = {"cloud"};
+	int woken = -WM_E_INVAL;	/* not slept yet */
+	unsigned posts;
+
 	while (!c.stop_request) {
+		posts = g_wm_stats.wm_cl_post_succ + g_wm_stats.wm_cl_post_fail;
 		cloud_loop();
-		cloud_sleep(&c);
+		/* A wakeup did something if it got a post out */
+		if (woken != -WM_E_INVAL)
+			wake_audit(&wp, woken == WM_SUCCESS ?
+				   WAKE_SEM : WAKE_TIMEOUT, posts !=
+				   g_wm_stats.wm_cl_post_succ +
+				   g_wm_stats.wm_cl_post_fail);
+		woken = cloud_sleep(&c);
 	}
 	c.stop_request = false;
 	os_thread_self_complete(NULL);
@@ -232,6 +281,14 @@ int cloud_start(const char *dev_class, void (*handle_req)(struct json_str
 	if (is_cloud_started)
 		return WM_SUCCESS;
 
+	/* Kept across stops, a post may still be queued */
+	if (!sem_mutex &&
+	    os_mutex_create(&sem_mutex, "cloud_sem", OS_MUTEX_INHERIT) !=
+	    WM_SUCCESS) {
+		cl_dbg("Cloud mutex creation error");
+		return -WM_FAIL;
+	}
+
 	ret = os_semaphore_create(&sem, "cloud_sem");
 	if (ret != WM_SUCCESS) {
 		cl_dbg("Cloud semaphore creation error %d", ret);
@@ -257,12 +314,15 @@ int cloud_stop(void)
 	if (!is_cloud_started)
 		return WM_SUCCESS;
 
+	wm_demo_netsched_stop(&cloud_job);
 	os_semaphore_put(&sem);
 
 	ret = cloud_actual_stop();
 
-	os_semaphore_delete(&sem);
+	os_mutex_get(&sem_mutex, OS_WAIT_FOREVER);
 	is_cloud_started = 0;
+	os_semaphore_delete(&sem);
+	os_mutex_put(&sem_mutex);
 
 	return ret;
 }